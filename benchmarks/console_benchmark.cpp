@@ -0,0 +1,230 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+// Replays captured (or generated) Invader output into a console widget and reports how fast it keeps up.
+//
+// Capture real output with something like:
+//     INVADER_FORCE_COLORS=1 invader-build ... > build.log 2>&1
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTimer>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "console_box.hpp"
+#include "console_view.hpp"
+#include "console_stream.hpp"
+
+static QByteArray generate_output(qint64 size) {
+    static const char *tags[] = {
+        "weapons\\pistol\\pistol.weapon",
+        "levels\\test\\bloodgulch\\bloodgulch.scenario_structure_bsp",
+        "characters\\cyborg\\cyborg.gbxmodel",
+        "sound\\sfx\\weapons\\pistol\\fire.sound",
+        "effects\\particles\\solid\\sparks.particle"
+    };
+
+    QByteArray output;
+    output.reserve(size + 256);
+    for(qint64 line = 0; output.size() < size; line++) {
+        auto *tag = tags[line % (sizeof(tags) / sizeof(*tags))];
+        switch(line % 10) {
+            case 0:
+                output += QByteArray("\x1B[1;33mWARNING:\x1B[m ") + tag + ": Bitmap #0 has mipmaps that aren't multiples of 4 (this might not work on some hardware)\n";
+                break;
+            case 1:
+                output += QByteArray("\x1B[38;5;8mWARNING (minor):\x1B[m ") + tag + ": Shader is using a deprecated function\n";
+                break;
+            case 2:
+                output += "Reading tags...\r\n";
+                break;
+            default:
+                output += QByteArray("Compiled ") + tag + " (" + QByteArray::number(line) + " / ~)\n";
+                break;
+        }
+    }
+    return output;
+}
+
+static qint64 peak_rss_kib() {
+    #ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<qint64>(counters.PeakWorkingSetSize / 1024);
+    }
+    return 0;
+    #else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    #ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+    #else
+    return usage.ru_maxrss;
+    #endif
+    #endif
+}
+
+static double percentile(std::vector<qint64> &values, double p) {
+    if(values.empty()) {
+        return 0.0;
+    }
+    auto index = static_cast<std::size_t>(p / 100.0 * static_cast<double>(values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index] / 1000.0;
+}
+
+int main(int argc, char **argv) {
+    // Never needs a display
+    if(qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication a(argc, argv);
+    a.setOrganizationName("SnowyMouse");
+    a.setApplicationName("six-shooter-console-benchmark");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Replay console output into a Six Shooter console and measure throughput");
+    parser.addHelpOption();
+    QCommandLineOption input_option(QStringList() << "i" << "input", "Captured output to replay (default: generated Invader-like output).", "file");
+    QCommandLineOption size_option(QStringList() << "s" << "size", "Size of the generated output in MiB (default: 32).", "MiB", "32");
+    QCommandLineOption chunk_option(QStringList() << "c" << "chunk-size", "Bytes per read (default: 4096).", "bytes", "4096");
+    QCommandLineOption rate_option(QStringList() << "r" << "rate", "Bytes per second to replay at; 0 is as fast as possible (default: 0).", "bytes", "0");
+    QCommandLineOption widget_option(QStringList() << "w" << "widget", "Console to use: box or view (default: box).", "widget", "box");
+    parser.addOption(input_option);
+    parser.addOption(size_option);
+    parser.addOption(chunk_option);
+    parser.addOption(rate_option);
+    parser.addOption(widget_option);
+    parser.process(a);
+
+    QByteArray output;
+    if(parser.isSet(input_option)) {
+        QFile file(parser.value(input_option));
+        if(!file.open(QIODevice::OpenModeFlag::ReadOnly)) {
+            std::fprintf(stderr, "Failed to open %s\n", file.fileName().toLocal8Bit().data());
+            return EXIT_FAILURE;
+        }
+        output = file.readAll();
+    }
+    else {
+        output = generate_output(parser.value(size_option).toLongLong() * 1024 * 1024);
+    }
+
+    auto chunk_size = std::max(parser.value(chunk_option).toLongLong(), 1LL);
+    auto rate = parser.value(rate_option).toLongLong();
+    bool use_view = parser.value(widget_option) == "view";
+
+    SixShooter::ConsoleStream stream(SixShooter::ConsoleStream::StandardOutput);
+    QWidget *widget;
+    if(use_view) {
+        auto *view = new SixShooter::ConsoleView();
+        view->set_stream(&stream);
+        widget = view;
+    }
+    else {
+        auto *box = new SixShooter::ConsoleBox();
+        box->set_stream(&stream);
+        widget = box;
+    }
+    widget->show();
+
+    // Split it up like reads from a pipe would
+    std::vector<QByteArray> chunks;
+    for(qint64 offset = 0; offset < output.size(); offset += chunk_size) {
+        chunks.emplace_back(output.mid(offset, chunk_size));
+    }
+    auto chunk_count = chunks.size();
+
+    std::vector<qint64> ingest_latency_ns(chunk_count);
+    std::vector<qint64> ingested_at_ns(chunk_count);
+    std::vector<qint64> draw_latency_ns;
+    draw_latency_ns.reserve(chunk_count);
+    std::atomic<std::size_t> ingested { 0 };
+    std::size_t drawn = 0;
+
+    QElapsedTimer clock;
+    clock.start();
+    qint64 producer_time_ns = 0;
+    qint64 last_draw_ns = 0;
+
+    // Views draw in their own slot first since they connected first
+    QObject::connect(&stream, &SixShooter::ConsoleStream::output_ready, &stream, [&]() {
+        auto now = clock.nsecsElapsed();
+        auto available = ingested.load();
+        for(; drawn < available; drawn++) {
+            draw_latency_ns.emplace_back(now - ingested_at_ns[drawn]);
+        }
+        last_draw_ns = now;
+    });
+
+    // Feed it from another thread, like the console thread would
+    std::thread producer([&]() {
+        auto start = clock.nsecsElapsed();
+        for(std::size_t i = 0; i < chunk_count; i++) {
+            if(rate > 0) {
+                auto due = start + static_cast<qint64>(static_cast<double>(i) * chunk_size / rate * 1000000000.0);
+                auto wait = due - clock.nsecsElapsed();
+                if(wait > 0) {
+                    std::this_thread::sleep_for(std::chrono::nanoseconds(wait));
+                }
+            }
+
+            auto before = clock.nsecsElapsed();
+            stream.ingest(chunks[i]);
+            auto after = clock.nsecsElapsed();
+
+            ingest_latency_ns[i] = after - before;
+            ingested_at_ns[i] = after;
+            ingested++;
+        }
+        producer_time_ns = clock.nsecsElapsed() - start;
+    });
+
+    // Stop once everything was drawn, or once nothing more comes in for a while (e.g. trailing escape codes)
+    QTimer done_timer;
+    done_timer.setInterval(50);
+    QObject::connect(&done_timer, &QTimer::timeout, &a, [&]() {
+        if(ingested.load() != chunk_count) {
+            return;
+        }
+        if(drawn == chunk_count || clock.nsecsElapsed() - std::max(last_draw_ns, ingested_at_ns[chunk_count - 1]) > 500000000) {
+            a.quit();
+        }
+    });
+    done_timer.start();
+
+    if(chunk_count > 0) {
+        a.exec();
+    }
+    producer.join();
+
+    auto total_ns = std::max(last_draw_ns, static_cast<qint64>(1));
+    auto megabytes = output.size() / 1000000.0;
+    auto statistics = stream.get_statistics();
+
+    std::printf("Widget:               %s\n", use_view ? "ConsoleView" : "ConsoleBox");
+    std::printf("Input:                %.2f MB in %zu chunks of %lld bytes\n", megabytes, chunk_count, static_cast<long long>(chunk_size));
+    std::printf("Ingested:             %.2f MB/s (%.3f s)\n", megabytes / (std::max(producer_time_ns, static_cast<qint64>(1)) / 1e9), producer_time_ns / 1e9);
+    std::printf("Drawn:                %.2f MB/s (%.3f s, %lld frames, %lld ms drawing)\n", megabytes / (total_ns / 1e9), total_ns / 1e9, static_cast<long long>(statistics.flushes), static_cast<long long>(statistics.flush_time_ms));
+    std::printf("Ingest latency (us):  p50 %.1f, p90 %.1f, p99 %.1f, max %.1f\n", percentile(ingest_latency_ns, 50), percentile(ingest_latency_ns, 90), percentile(ingest_latency_ns, 99), percentile(ingest_latency_ns, 100));
+    std::printf("Draw latency (us):    p50 %.1f, p90 %.1f, p99 %.1f, max %.1f\n", percentile(draw_latency_ns, 50), percentile(draw_latency_ns, 90), percentile(draw_latency_ns, 99), percentile(draw_latency_ns, 100));
+    std::printf("Peak RSS:             %.1f MiB\n", peak_rss_kib() / 1024.0);
+
+    delete widget;
+    return EXIT_SUCCESS;
+}
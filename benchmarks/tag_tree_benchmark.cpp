@@ -0,0 +1,234 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+// Loads synthetic tag lists into a tag tree and reports how long it takes to build and show.
+//
+// Peak RSS only ever goes up, so run one count at a time (--count) for memory numbers that mean anything.
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEvent>
+#include <QTimer>
+#include <cstdio>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "tag_tree_dialog.hpp"
+#include "tag_tree_model.hpp"
+#include "tag_tree_widget.hpp"
+
+enum class Shape {
+    Realistic,
+    Flat,
+    Deep
+};
+
+static QStringList generate_tags(std::size_t count, Shape shape, std::mt19937 &random) {
+    static const char *top_directories[] = {
+        "bitmaps", "characters", "cinematics", "effects", "globals", "levels", "powerups", "scenery", "shaders", "sound",
+        "ui", "vehicles", "weapons"
+    };
+    static const char *words[] = {
+        "cyborg", "elite", "grunt", "jackal", "hunter", "marine", "warthog", "ghost", "banshee", "pistol", "rifle",
+        "plasma", "needler", "rocket", "sniper", "shotgun", "fire", "impact", "sparks", "smoke", "detail", "base", "bump",
+        "multipurpose", "fp", "hud", "test", "bloodgulch", "danger_canyon", "infinity", "a10", "b30", "c40", "d20"
+    };
+    static const char *classes[] = {
+        "bitmap", "shader_model", "shader_environment", "gbxmodel", "model_animations", "sound", "effect", "particle",
+        "weapon", "vehicle", "biped", "scenery", "damage_effect", "object", "hud_interface", "scenario_structure_bsp",
+        "sound_environment", "light"
+    };
+
+    // Most tags are 2-4 directories deep
+    std::discrete_distribution<int> depth_distribution({ 1, 3, 5, 4, 2, 1 });
+    std::uniform_int_distribution<std::size_t> top_distribution(0, std::size(top_directories) - 1);
+    std::uniform_int_distribution<std::size_t> word_distribution(0, std::size(words) - 1);
+    std::uniform_int_distribution<std::size_t> class_distribution(0, std::size(classes) - 1);
+    std::uniform_int_distribution<int> none_distribution(0, 49);
+
+    QStringList tags;
+    tags.reserve(count);
+
+    for(std::size_t i = 0; i < count; i++) {
+        QString tag;
+        int depth;
+        switch(shape) {
+            case Shape::Realistic:
+                depth = depth_distribution(random) + 1;
+                break;
+            case Shape::Flat:
+                depth = 1;
+                break;
+            case Shape::Deep:
+                depth = 24;
+                break;
+        }
+
+        tag += top_directories[shape == Shape::Flat ? 0 : top_distribution(random)];
+        for(int d = 1; d < depth; d++) {
+            tag += '\\';
+            tag += words[word_distribution(random)];
+        }
+
+        // invader-info lists tags it can't identify as .none (about 2% of them here)
+        tag += '\\';
+        tag += QString("%1_%2").arg(words[word_distribution(random)]).arg(i);
+        tag += '.';
+        tag += none_distribution(random) == 0 ? "none" : classes[class_distribution(random)];
+
+        tags.emplace_back(std::move(tag));
+    }
+
+    return tags;
+}
+
+static qint64 peak_rss_kib() {
+    #ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if(GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return static_cast<qint64>(counters.PeakWorkingSetSize / 1024);
+    }
+    return 0;
+    #else
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    #ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+    #else
+    return usage.ru_maxrss;
+    #endif
+    #endif
+}
+
+// Calls back on the first paint of the viewport once the tree finished loading
+class FirstPaintFilter : public QObject {
+public:
+    FirstPaintFilter(SixShooter::TagTreeWidget *tree, std::function<void()> callback) : tree(tree), callback(std::move(callback)) {}
+
+protected:
+    bool eventFilter(QObject *object, QEvent *event) override {
+        if(event->type() == QEvent::Type::Paint && !this->tree->is_loading() && this->callback) {
+            auto callback = std::move(this->callback);
+            this->callback = nullptr;
+            callback();
+        }
+        return QObject::eventFilter(object, event);
+    }
+
+private:
+    SixShooter::TagTreeWidget *tree;
+    std::function<void()> callback;
+};
+
+int main(int argc, char **argv) {
+    // Never needs a display
+    if(qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication a(argc, argv);
+    a.setOrganizationName("SnowyMouse");
+    a.setApplicationName("six-shooter-tag-tree-benchmark");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Load synthetic tag lists into a Six Shooter tag tree and measure how long it takes");
+    parser.addHelpOption();
+    QCommandLineOption count_option(QStringList() << "n" << "count", "Number of tags; can be given more than once (default: 1000, 10000, 100000, 500000).", "tags");
+    QCommandLineOption shape_option(QStringList() << "s" << "shape", "Directory layout: realistic, flat (one directory) or deep (24 levels) (default: realistic).", "shape", "realistic");
+    QCommandLineOption widget_option(QStringList() << "w" << "widget", "Where to load the tags: tree or dialog (default: tree).", "widget", "tree");
+    QCommandLineOption seed_option("seed", "Random seed (default: 1).", "seed", "1");
+    parser.addOption(count_option);
+    parser.addOption(shape_option);
+    parser.addOption(widget_option);
+    parser.addOption(seed_option);
+    parser.process(a);
+
+    std::vector<std::size_t> counts;
+    for(auto &count : parser.values(count_option)) {
+        counts.emplace_back(count.toULongLong());
+    }
+    if(counts.empty()) {
+        counts = { 1000, 10000, 100000, 500000 };
+    }
+
+    auto shape_name = parser.value(shape_option);
+    auto shape = shape_name == "flat" ? Shape::Flat : shape_name == "deep" ? Shape::Deep : Shape::Realistic;
+    bool use_dialog = parser.value(widget_option) == "dialog";
+
+    std::mt19937 random(parser.value(seed_option).toUInt());
+
+    std::printf("%-10s %12s %12s %12s %12s %12s\n", "Tags", "Build (ms)", "Index (ms)", "Call (ms)", "Paint (ms)", "Peak RSS");
+
+    for(auto count : counts) {
+        auto tags = generate_tags(count, shape, random);
+
+        // Building on its own, without any widgets involved
+        QElapsedTimer build_timer;
+        build_timer.start();
+        SixShooter::TagTree tree;
+        tree.build(tags);
+        auto build_ms = build_timer.nsecsElapsed() / 1e6;
+
+        build_timer.restart();
+        SixShooter::TagSearchIndex index;
+        index.build(tree);
+        auto index_ms = build_timer.nsecsElapsed() / 1e6;
+
+        // Then the whole thing from set_data to the first paint with the tree in it
+        SixShooter::TagTreeDialog *dialog = nullptr;
+        SixShooter::TagTreeWidget *widget = nullptr;
+        QWidget *window;
+        if(use_dialog) {
+            dialog = new SixShooter::TagTreeDialog();
+            widget = dialog->findChild<SixShooter::TagTreeWidget *>();
+            window = dialog;
+        }
+        else {
+            widget = new SixShooter::TagTreeWidget();
+            widget->resize(600, 600);
+            window = widget;
+        }
+        window->show();
+
+        QElapsedTimer paint_timer;
+        qint64 paint_ns = -1;
+        FirstPaintFilter filter(widget, [&]() {
+            paint_ns = paint_timer.nsecsElapsed();
+            QTimer::singleShot(0, &a, &QApplication::quit);
+        });
+        widget->viewport()->installEventFilter(&filter);
+
+        paint_timer.start();
+        if(use_dialog) {
+            dialog->set_data(tags);
+        }
+        else {
+            widget->set_data(tags);
+        }
+        auto call_ms = paint_timer.nsecsElapsed() / 1e6;
+
+        // Give up on it eventually
+        QTimer timeout;
+        timeout.setSingleShot(true);
+        QObject::connect(&timeout, &QTimer::timeout, &a, &QApplication::quit);
+        timeout.start(300000);
+        a.exec();
+
+        widget->viewport()->removeEventFilter(&filter);
+        delete window;
+
+        std::printf("%-10zu %12.1f %12.1f %12.2f %12.1f %9.1f MiB\n", count, build_ms, index_ms, call_ms, paint_ns < 0 ? -1.0 : paint_ns / 1e6, peak_rss_kib() / 1024.0);
+        std::fflush(stdout);
+    }
+
+    return EXIT_SUCCESS;
+}
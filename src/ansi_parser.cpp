@@ -0,0 +1,262 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <QColor>
+#include <QFont>
+#include <array>
+
+#include "ansi_parser.hpp"
+
+namespace SixShooter {
+    // The first 16 colors are Six Shooter's own; the rest are the standard xterm color cube and grayscale ramp
+    static constexpr std::array<QRgb, 256> make_palette() {
+        std::array<QRgb, 256> palette = {
+            0x000000, 0xFF0000, 0x00FF00, 0xFFFF00, 0x0000FF, 0xFF00FF, 0x00FFFF, 0xFFFFFF,
+            0x3F3F3F, 0x7F0000, 0x007F00, 0x7F7F00, 0x00007F, 0x7F007F, 0x007F7F, 0x7F7F7F
+        };
+
+        constexpr QRgb levels[] = { 0x00, 0x5F, 0x87, 0xAF, 0xD7, 0xFF };
+        for(std::size_t i = 0; i < 216; i++) {
+            palette[16 + i] = (levels[i / 36] << 16) | (levels[i / 6 % 6] << 8) | levels[i % 6];
+        }
+
+        for(std::size_t i = 0; i < 24; i++) {
+            QRgb level = 8 + i * 10;
+            palette[232 + i] = (level << 16) | (level << 8) | level;
+        }
+
+        return palette;
+    }
+
+    static constexpr std::array<QRgb, 256> PALETTE = make_palette();
+
+    // Longest parameter string we'll hold on to before giving up on a sequence
+    static constexpr qsizetype MAX_PARAMETERS_LENGTH = 64;
+
+    QRgb AnsiParser::palette_color(std::uint8_t index) noexcept {
+        return PALETTE[index];
+    }
+
+    QColor AnsiParser::Style::foreground_color() const {
+        if(this->flags & Flags::Concealed) {
+            return this->background_color();
+        }
+
+        QColor color(this->foreground == DEFAULT_COLOR ? DEFAULT_FOREGROUND : this->foreground);
+        if(this->flags & Flags::Faint) {
+            color.setAlphaF(0.75);
+        }
+        return color;
+    }
+
+    QColor AnsiParser::Style::background_color() const {
+        return QColor(this->background == DEFAULT_COLOR ? DEFAULT_BACKGROUND : this->background);
+    }
+
+    QTextCharFormat AnsiParser::Style::to_format() const {
+        QTextCharFormat format;
+        format.setForeground(this->foreground_color());
+
+        if(this->background != DEFAULT_COLOR) {
+            format.setBackground(this->background_color());
+        }
+
+        if(this->flags & Flags::Bold) {
+            format.setFontWeight(QFont::Weight::Bold);
+        }
+
+        if(this->flags & Flags::Underline) {
+            format.setFontUnderline(true);
+        }
+
+        return format;
+    }
+
+    AnsiParser::AnsiParser() : decoder(QStringDecoder::Encoding::Utf8) {}
+
+    void AnsiParser::reset() {
+        this->decoder.resetState();
+        this->state = State::Text;
+        this->parameters.clear();
+        this->style = {};
+    }
+
+    void AnsiParser::feed(const QByteArray &data, std::vector<Span> &spans) {
+        // Any incomplete multibyte character is held by the decoder until the next chunk
+        QString text = this->decoder.decode(data);
+
+        QString run;
+        auto flush_run = [&run, &spans, this]() {
+            if(!run.isEmpty()) {
+                spans.emplace_back(Span { std::move(run), this->style });
+                run = QString();
+            }
+        };
+
+        auto length = text.size();
+        qsizetype run_start = 0;
+
+        for(qsizetype i = 0; i < length; i++) {
+            auto c = text.at(i);
+
+            switch(this->state) {
+                case State::Text:
+                    if(c == u'\x1B' || c == u'\r') {
+                        run += QStringView(text).mid(run_start, i - run_start);
+                        if(c == u'\x1B') {
+                            flush_run();
+                            this->state = State::Escape;
+                        }
+                        run_start = i + 1;
+                    }
+                    break;
+
+                case State::Escape:
+                    if(c == u'[') {
+                        this->parameters.clear();
+                        this->state = State::ControlSequence;
+                    }
+                    else {
+                        // Not something we handle; drop it
+                        this->state = State::Text;
+                    }
+                    run_start = i + 1;
+                    break;
+
+                case State::ControlSequence: {
+                    auto u = c.unicode();
+
+                    // Parameter bytes
+                    if(u >= 0x30 && u <= 0x3F) {
+                        if(this->parameters.size() < MAX_PARAMETERS_LENGTH) {
+                            this->parameters += c;
+                        }
+                    }
+
+                    // Final byte (anything other than intermediate bytes ends the sequence)
+                    else if(u < 0x20 || u > 0x2F) {
+                        if(c == u'm') {
+                            this->apply_sgr(this->parameters);
+                        }
+                        this->parameters.clear();
+                        this->state = State::Text;
+                    }
+
+                    run_start = i + 1;
+                    break;
+                }
+            }
+        }
+
+        if(this->state == State::Text && run_start < length) {
+            run += QStringView(text).mid(run_start);
+        }
+
+        flush_run();
+    }
+
+    void AnsiParser::apply_sgr(QStringView parameters) {
+        // Split into numbers; an empty parameter counts as 0
+        std::vector<int> codes;
+        for(auto &i : parameters.split(u';')) {
+            bool ok;
+            int n = i.isEmpty() ? 0 : i.toInt(&ok, 10);
+            if(!i.isEmpty() && !ok) {
+                return;
+            }
+            codes.emplace_back(n);
+        }
+
+        auto code_count = codes.size();
+
+        // 38/48 take either ";5;n" (palette) or ";2;r;g;b" (truecolor); returns false if it's malformed
+        auto extended_color = [&codes, &code_count](std::size_t &index, std::uint32_t &color) -> bool {
+            if(index + 2 < code_count && codes[index + 1] == 5) {
+                auto n = codes[index + 2];
+                if(n < 0 || n > 255) {
+                    return false;
+                }
+                color = PALETTE[n];
+                index += 2;
+                return true;
+            }
+            else if(index + 4 < code_count && codes[index + 1] == 2) {
+                auto r = codes[index + 2], g = codes[index + 3], b = codes[index + 4];
+                if(r < 0 || r > 255 || g < 0 || g > 255 || b < 0 || b > 255) {
+                    return false;
+                }
+                color = (static_cast<std::uint32_t>(r) << 16) | (static_cast<std::uint32_t>(g) << 8) | static_cast<std::uint32_t>(b);
+                index += 4;
+                return true;
+            }
+            return false;
+        };
+
+        for(std::size_t index = 0; index < code_count; index++) {
+            auto n = codes[index];
+
+            // Colors; the base colors here are already full intensity, so the "bright" variants use the same ones
+            if(n >= 30 && n <= 37) {
+                this->style.foreground = PALETTE[n - 30];
+                continue;
+            }
+            if(n >= 90 && n <= 97) {
+                this->style.foreground = PALETTE[n - 90];
+                continue;
+            }
+            if(n >= 40 && n <= 47) {
+                this->style.background = PALETTE[n - 40];
+                continue;
+            }
+            if(n >= 100 && n <= 107) {
+                this->style.background = PALETTE[n - 100];
+                continue;
+            }
+
+            switch(n) {
+                case 0:
+                    this->style = {};
+                    break;
+                case 1:
+                    this->style.flags |= Style::Flags::Bold;
+                    break;
+                case 2:
+                    this->style.flags |= Style::Flags::Faint;
+                    break;
+                case 4:
+                    this->style.flags |= Style::Flags::Underline;
+                    break;
+                case 8:
+                    this->style.flags |= Style::Flags::Concealed;
+                    break;
+                case 22:
+                    this->style.flags &= ~(Style::Flags::Bold | Style::Flags::Faint);
+                    break;
+                case 24:
+                    this->style.flags &= ~Style::Flags::Underline;
+                    break;
+                case 28:
+                    this->style.flags &= ~Style::Flags::Concealed;
+                    break;
+                case 38:
+                    if(!extended_color(index, this->style.foreground)) {
+                        // Unsupported color format; skip the rest of this sequence
+                        return;
+                    }
+                    break;
+                case 39:
+                    this->style.foreground = Style::DEFAULT_COLOR;
+                    break;
+                case 48:
+                    if(!extended_color(index, this->style.background)) {
+                        return;
+                    }
+                    break;
+                case 49:
+                    this->style.background = Style::DEFAULT_COLOR;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+}
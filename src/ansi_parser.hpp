@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SIX_SHOOTER_ANSI_PARSER_HPP
+#define SIX_SHOOTER_ANSI_PARSER_HPP
+
+#include <QString>
+#include <QColor>
+#include <QStringDecoder>
+#include <QTextCharFormat>
+#include <cstdint>
+#include <vector>
+
+namespace SixShooter {
+    class AnsiParser {
+    public:
+        // Colors used when no color is set
+        static constexpr QRgb DEFAULT_FOREGROUND = 0xEEEEEE;
+        static constexpr QRgb DEFAULT_BACKGROUND = 0x000000;
+
+        struct Style {
+            enum Flags : std::uint8_t {
+                Bold = 1 << 0,
+                Faint = 1 << 1,
+                Underline = 1 << 2,
+                Concealed = 1 << 3
+            };
+
+            // Colors are 0xRRGGBB, or DEFAULT_COLOR to use the console's own colors
+            static constexpr std::uint32_t DEFAULT_COLOR = 0x1000000;
+
+            std::uint32_t foreground = DEFAULT_COLOR;
+            std::uint32_t background = DEFAULT_COLOR;
+            std::uint8_t flags = 0;
+
+            bool operator==(const Style &other) const noexcept {
+                return this->foreground == other.foreground && this->background == other.background && this->flags == other.flags;
+            }
+            bool operator!=(const Style &other) const noexcept {
+                return !(*this == other);
+            }
+
+            // Unique for every distinct style, for caching whatever gets made from it
+            std::uint64_t key() const noexcept {
+                return static_cast<std::uint64_t>(this->foreground) | (static_cast<std::uint64_t>(this->background) << 25) | (static_cast<std::uint64_t>(this->flags) << 50);
+            }
+
+            QColor foreground_color() const;
+            QColor background_color() const;
+            QTextCharFormat to_format() const;
+        };
+
+        struct Span {
+            QString text;
+            Style style;
+        };
+
+        // Color for a 256-color palette index (0-255)
+        static QRgb palette_color(std::uint8_t index) noexcept;
+
+        AnsiParser();
+
+        // Decode the next chunk of output, appending text runs to spans. Escape sequences and multibyte characters may be split across calls.
+        void feed(const QByteArray &data, std::vector<Span> &spans);
+
+        // Drop any partial sequence and return to the default style
+        void reset();
+
+    private:
+        enum State {
+            Text,
+            Escape,
+            ControlSequence
+        };
+
+        void apply_sgr(QStringView parameters);
+
+        QStringDecoder decoder;
+        State state = State::Text;
+        QString parameters;
+        Style style;
+    };
+}
+
+#endif
@@ -4,18 +4,22 @@
 #include <QStyle>
 #include <QFontDatabase>
 #include <QApplication>
-#include <QProcess>
 #include <QScrollBar>
 #include <QTextDocument>
-#include <optional>
+#include <QTextCursor>
+#include <QTextBlock>
+#include <QElapsedTimer>
 
 #include "console_box.hpp"
+#include "console_stream.hpp"
+#include "settings.hpp"
 
 #define TEXT_COLOR "#EEE"
 
 namespace SixShooter {
     ConsoleBox::ConsoleBox(QWidget *parent) : QTextEdit(parent) {
         this->setReadOnly(true);
+        this->setUndoRedoEnabled(false);
         auto font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
 
         auto margins = this->contentsMargins();
@@ -30,233 +34,95 @@ namespace SixShooter {
         this->setMinimumHeight(font_metrics.ascent() * 24 + this->frameWidth() * 2 + margins.top() + margins.bottom() + document_margin * 2);
 
         this->setStyleSheet("QTextEdit { background-color: #000; color: " TEXT_COLOR ";}");
-    }
 
-    void ConsoleBox::reset_contents() {
-        this->html = {};
-        this->clear();
+        SixShooterSettings settings;
+        this->max_lines = settings.value("console_scrollback_lines", DEFAULT_SCROLLBACK_LINES).toInt();
+        this->max_bytes = settings.value("console_scrollback_bytes", DEFAULT_SCROLLBACK_BYTES).toLongLong();
     }
 
-    void ConsoleBox::attach_to_process(QProcess *process, OutputChannel channel) {
-        if(channel == OutputChannel::StandardError) {
-            connect(process, &QProcess::readyReadStandardError, this, &ConsoleBox::on_standard_error);
-        }
-        else if(channel == OutputChannel::StandardOutput) {
-            connect(process, &QProcess::readyReadStandardOutput, this, &ConsoleBox::on_standard_output);
-        }
-
-        this->process = process;
+    void ConsoleBox::set_stream(ConsoleStream *stream) {
+        connect(stream, &ConsoleStream::output_ready, this, &ConsoleBox::append_output);
+        connect(stream, &ConsoleStream::cleared, this, &ConsoleBox::reset_contents);
+        this->stream = stream;
     }
 
-    static void vt100(QString &string) {
-        // Close these
-        string.replace("\x1B[m", "</span>");
-
-        // Look for more
-        while(true) {
-            auto next_index = string.indexOf("\x1B[");
-            if(next_index == -1) {
-                break;
-            }
-
-            auto cursor = next_index + 2;
-            auto next_char_maybe = [&cursor, &string]() -> std::optional<QChar> {
-                if(cursor == string.size()) {
-                    return std::nullopt;
-                }
-                else {
-                    return string.at(cursor++);
-                }
-            };
-
-            QString val;
-
-            QString css;
-            QString color = TEXT_COLOR;
-
-            auto get_next_value = [&next_char_maybe, &cursor](bool &done) -> std::optional<QString> {
-                QString s;
-
-                while(true) {
-                    auto next_char = next_char_maybe();
-                    if(!next_char.has_value()) {
-                        return std::nullopt;
-                    }
-
-                    if(*next_char == ';' || *next_char == 'm') {
-                        done = *next_char == 'm';
-                        break;
-                    }
+    void ConsoleBox::reset_contents() {
+        this->clear();
+        this->block_sizes = { 0 };
+        this->total_bytes = 0;
+    }
 
-                    s += *next_char;
-                }
+    void ConsoleBox::append_output(const std::vector<AnsiParser::Span> &spans) {
+        QElapsedTimer flush_timer;
+        flush_timer.start();
 
-                return s;
-            };
+        // Only insert the new text at the end of the document rather than re-rendering everything we have so far
+        QTextCursor cursor(this->document());
+        cursor.movePosition(QTextCursor::MoveOperation::End);
+        cursor.beginEditBlock();
 
-            QStringList all_vals;
+        for(auto &span : spans) {
+            cursor.insertText(span.text, this->format_for(span.style));
 
+            // Keep track of how big each block is; every newline starts a new block
+            qsizetype start = 0;
             while(true) {
-                bool done;
-                auto next_value = get_next_value(done);
-                if(!next_value.has_value()) {
-                    std::printf("VT100 fail: Unexpected end?\n");
-                    return;
-                }
-                all_vals << *next_value;
-                if(done) {
+                auto newline = span.text.indexOf(u'\n', start);
+                auto end = newline == -1 ? span.text.size() : newline;
+                auto bytes = static_cast<qint64>((end - start) * sizeof(QChar));
+                this->block_sizes.back() += bytes;
+                this->total_bytes += bytes;
+                if(newline == -1) {
                     break;
                 }
+                this->block_sizes.emplace_back(0);
+                start = newline + 1;
             }
+        }
 
-            int index = 0;
-            while(index < all_vals.size()) {
-                auto next_value = all_vals[index++];
-
-                auto set_color_based_on_code = [&color](int code) {
-                    switch(code) {
-                        case 0:
-                            color = "#000000";
-                            return;
-                        case 1:
-                            color = "#FF0000";
-                            return;
-                        case 2:
-                            color = "#00FF00";
-                            return;
-                        case 3:
-                            color = "#FFFF00";
-                            return;
-                        case 4:
-                            color = "#0000FF";
-                            return;
-                        case 5:
-                            color = "#FF00FF";
-                            return;
-                        case 6:
-                            color = "#FFFF00";
-                            return;
-                        case 7:
-                            color = "#FFFFFF";
-                            return;
-                        case 8:
-                            color = "#3F3F3F";
-                            return;
-                        case 9:
-                            color = "#7F0000";
-                            return;
-                        case 10:
-                            color = "#007F00";
-                            return;
-                        case 11:
-                            color = "#7F7F00";
-                            return;
-                        case 12:
-                            color = "#00007F";
-                            return;
-                        case 13:
-                            color = "#7F007F";
-                            return;
-                        case 14:
-                            color = "#7F7F00";
-                            return;
-                        case 15:
-                            color = "#7F7F7F";
-                            return;
-                        default:
-                            color = TEXT_COLOR;
-                            break;
-                    }
-                };
-
-                bool ok;
-                int n = (next_value).toInt(&ok, 10);
-                if(!ok) {
-                    std::printf("VT100 fail: Failed to parse %s into a number\n", next_value.toLatin1().data());
-                    break;
-                }
-
-                switch(n) {
-                    case 0:
-                        css.clear();
-                        color = TEXT_COLOR;
-                        break;
-                    case 1:
-                        css += "font-weight:bold;";
-                        break;
-                    case 2:
-                        css += "opacity:0.75;";
-                        break;
-                    case 4:
-                        css += "text-style:underline;";
-                        break;
-                    case 8:
-                        css += "opacity:0.0;";
-                        break;
-                    case 30:
-                    case 31:
-                    case 32:
-                    case 33:
-                    case 34:
-                    case 35:
-                    case 36:
-                    case 37:
-                        set_color_based_on_code(n - 30);
-                        break;
-                    case 38: {
-                        auto type = all_vals[index++];
+        cursor.endEditBlock();
 
-                        if(type == "5") {
-                            auto code = all_vals[index++];
-                            int n = code.toInt(&ok, 10);
-                            if(!ok) {
-                                std::printf("VT100 fail: Invalid color code?\n");
-                                break;
-                            }
-                            set_color_based_on_code(n);
-                        }
-                        else {
-                            std::printf("VT100 fail: Unknown color format %s?\n", type.toLatin1().data());
-                            break;
-                        }
-                    }
-                }
-            }
+        this->trim_scrollback();
+        this->verticalScrollBar()->setValue(this->verticalScrollBar()->maximum());
 
-            QString s = "</span><span style=\"color:" + color + ";" + css + "\">";
-            string.replace(next_index, cursor - next_index, s);
-        }
+        this->stream->record_flush_time(flush_timer.elapsed());
+        this->setToolTip(this->stream->get_statistics_summary());
     }
 
-    static void clean_string(QString &string) {
-        string.replace("&", "&amp;");
-        string.replace("<", "&lt;");
-        string.replace(">", "&gt;");
-        string.replace("\n", "<br/>");
-        string.replace("\r", "");
-        string.replace(" ", "&nbsp;");
-
-        // Handle VT100 text colors
-        vt100(string);
+    const QTextCharFormat &ConsoleBox::format_for(const AnsiParser::Style &style) {
+        auto key = style.key();
+        auto existing = this->formats.constFind(key);
+        if(existing != this->formats.constEnd()) {
+            return *existing;
+        }
+        return *this->formats.insert(key, style.to_format());
     }
 
-    void ConsoleBox::on_standard_output() {
-        auto stdout_data = QString(this->process->readAllStandardOutput());
-        clean_string(stdout_data);
-
-        this->html += (QString("<span style=\"color: " TEXT_COLOR "\">") + stdout_data + "</span>").toStdString();
-
-        this->setHtml(this->html.c_str());
-        this->verticalScrollBar()->setValue(this->verticalScrollBar()->maximum());
-    }
+    void ConsoleBox::trim_scrollback() {
+        // Work out how many of the oldest blocks have to go (always keep the block we're writing to)
+        std::size_t drop_count = 0;
+        qint64 dropped_bytes = 0;
+        auto block_count = this->block_sizes.size();
+        while(drop_count + 1 < block_count) {
+            bool over_lines = this->max_lines > 0 && block_count - drop_count > static_cast<std::size_t>(this->max_lines);
+            bool over_bytes = this->max_bytes > 0 && this->total_bytes - dropped_bytes > this->max_bytes;
+            if(!over_lines && !over_bytes) {
+                break;
+            }
+            dropped_bytes += this->block_sizes[drop_count++];
+        }
 
-    void ConsoleBox::on_standard_error() {
-        auto stderr_data = QString(this->process->readAllStandardError());
-        clean_string(stderr_data);
+        if(drop_count == 0) {
+            return;
+        }
 
-        this->html += (QString("<span style=\"color: " TEXT_COLOR "\">") + stderr_data + "</span>").toStdString();
+        // Remove them all at once
+        QTextCursor cursor(this->document());
+        cursor.movePosition(QTextCursor::MoveOperation::Start);
+        cursor.movePosition(QTextCursor::MoveOperation::NextBlock, QTextCursor::MoveMode::KeepAnchor, static_cast<int>(drop_count));
+        cursor.removeSelectedText();
 
-        this->setHtml(this->html.c_str());
-        this->verticalScrollBar()->setValue(this->verticalScrollBar()->maximum());
+        this->block_sizes.erase(this->block_sizes.begin(), this->block_sizes.begin() + drop_count);
+        this->total_bytes -= dropped_bytes;
     }
 }
@@ -4,29 +4,41 @@
 #define SIX_SHOOTER_CONSOLE_BOX_HPP
 
 #include <QTextEdit>
+#include <QHash>
+#include <deque>
+#include <vector>
 
-class QProcess;
+#include "ansi_parser.hpp"
 
 namespace SixShooter {
+    class ConsoleStream;
+
     class ConsoleBox : public QTextEdit {
         Q_OBJECT
     public:
-        enum OutputChannel {
-            StandardOutput,
-            StandardError
-        };
+        // Scrollback limits used when nothing is set in the settings (0 means unlimited)
+        static constexpr int DEFAULT_SCROLLBACK_LINES = 10000;
+        static constexpr qint64 DEFAULT_SCROLLBACK_BYTES = 16 * 1024 * 1024;
 
         ConsoleBox(QWidget *parent = nullptr);
-        void attach_to_process(QProcess *process, OutputChannel channels);
+        void set_stream(ConsoleStream *stream);
         void reset_contents();
 
     private:
-        void on_standard_output();
-        void on_standard_error();
+        void append_output(const std::vector<AnsiParser::Span> &spans);
+        void trim_scrollback();
+        const QTextCharFormat &format_for(const AnsiParser::Style &style);
+
+        ConsoleStream *stream = nullptr;
 
-        QProcess *process = nullptr;
+        // Formats already made for each style; output tends to only ever use a handful of them
+        QHash<quint64, QTextCharFormat> formats;
 
-        std::string html;
+        // Size of each block in the document, oldest first, so we know how much to drop when over the limits
+        std::deque<qint64> block_sizes = { 0 };
+        qint64 total_bytes = 0;
+        int max_lines;
+        qint64 max_bytes;
     };
 }
 
@@ -2,42 +2,250 @@
 
 #include <QGroupBox>
 #include <QVBoxLayout>
+#include <QHBoxLayout>
 #include <QProcessEnvironment>
+#include <QProcess>
+#include <QThread>
+#include <QLineEdit>
+#include <QComboBox>
+#include <QTableView>
+#include <QHeaderView>
+#include <array>
 
 #include "console_dialog.hpp"
 #include "console_box.hpp"
+#include "console_view.hpp"
+#include "console_stream.hpp"
+#include "diagnostics_model.hpp"
+#include "settings.hpp"
 
 namespace SixShooter {
     ConsoleDialog::ConsoleDialog() {
+        this->console_thread = new QThread(this);
+        this->process_owner = new QObject();
+        this->process_owner->moveToThread(this->console_thread);
+        this->console_thread->start();
+
         this->console_widget = new QWidget(this);
         auto *console_layout = new QVBoxLayout(console_widget);
         console_layout->setContentsMargins(0, 0, 0, 0);
 
-        auto *stdout_widget = new QGroupBox("Output", this);
-        auto *stdout_layout = new QVBoxLayout(stdout_widget);
-        this->stdout_box = new ConsoleBox(console_widget);
-        stdout_layout->addWidget(this->stdout_box);
-        stdout_widget->setLayout(stdout_layout);
-        console_layout->addWidget(stdout_widget);
+        this->stdout_stream = new ConsoleStream(ConsoleStream::StandardOutput, this);
+        this->stderr_stream = new ConsoleStream(ConsoleStream::StandardError, this);
+
+        // The virtualized view can handle far bigger logs, but it doesn't wrap lines
+        bool virtualized = SixShooterSettings().value("console_virtualized", false).toBool();
+        auto make_console = [this, virtualized](ConsoleStream *stream) -> QWidget * {
+            if(virtualized) {
+                auto *view = new ConsoleView(this->console_widget);
+                view->set_stream(stream);
+                return view;
+            }
+            else {
+                auto *box = new ConsoleBox(this->console_widget);
+                box->set_stream(stream);
+                return box;
+            }
+        };
+
+        // Either one timestamped console with everything in the order it arrived, or separate output and error consoles
+        if(SixShooterSettings().value("console_unified", false).toBool()) {
+            this->unified_stream = new ConsoleStream(ConsoleStream::Unified, this);
+
+            // The separate streams still feed the diagnostics (they need lines without timestamps), but only the
+            // unified log goes to disk
+            this->stdout_stream->disable_log_to_disk();
+            this->stderr_stream->disable_log_to_disk();
+
+            auto *unified_widget = new QGroupBox("Output and errors", this);
+            auto *unified_layout = new QVBoxLayout(unified_widget);
+            unified_layout->addWidget(make_console(this->unified_stream));
+            unified_widget->setLayout(unified_layout);
+            console_layout->addWidget(unified_widget);
+        }
+        else {
+            auto *stdout_widget = new QGroupBox("Output", this);
+            auto *stdout_layout = new QVBoxLayout(stdout_widget);
+            stdout_layout->addWidget(make_console(this->stdout_stream));
+            stdout_widget->setLayout(stdout_layout);
+            console_layout->addWidget(stdout_widget);
+
+            auto *stderr_widget = new QGroupBox("Errors", this);
+            auto *stderr_layout = new QVBoxLayout(stderr_widget);
+            stderr_layout->addWidget(make_console(this->stderr_stream));
+            stderr_widget->setLayout(stderr_layout);
+            console_layout->addWidget(stderr_widget);
+        }
+
+        // Warnings and errors pulled out of both streams as they come in
+        this->diagnostics = new DiagnosticsModel(this);
+        this->diagnostics->attach_to_stream(this->stdout_stream);
+        this->diagnostics->attach_to_stream(this->stderr_stream);
+
+        this->diagnostics_widget = new QGroupBox(this);
+        auto *diagnostics_layout = new QVBoxLayout(this->diagnostics_widget);
+
+        auto *filter_widget = new QWidget(this->diagnostics_widget);
+        auto *filter_layout = new QHBoxLayout(filter_widget);
+        filter_layout->setContentsMargins(0, 0, 0, 0);
+        auto *filter_text = new QLineEdit(filter_widget);
+        filter_text->setPlaceholderText("Filter");
+        filter_text->setClearButtonEnabled(true);
+        filter_layout->addWidget(filter_text);
+        auto *filter_severity = new QComboBox(filter_widget);
+        for(int i = DiagnosticsParser::Severity::Pedantic; i <= DiagnosticsParser::Severity::FatalError; i++) {
+            filter_severity->addItem(QString(DiagnosticsParser::severity_name(static_cast<DiagnosticsParser::Severity>(i))) + " and up", i);
+        }
+        filter_layout->addWidget(filter_severity);
+        filter_widget->setLayout(filter_layout);
+        diagnostics_layout->addWidget(filter_widget);
 
-        auto *stderr_widget = new QGroupBox("Errors", this);
-        auto *stderr_layout = new QVBoxLayout(stderr_widget);
-        this->stderr_box = new ConsoleBox(console_widget);
-        stderr_layout->addWidget(this->stderr_box);
-        stderr_widget->setLayout(stderr_layout);
-        console_layout->addWidget(stderr_widget);
+        auto *filter_model = new DiagnosticsFilterModel(this);
+        filter_model->setSourceModel(this->diagnostics);
+        connect(filter_text, &QLineEdit::textChanged, filter_model, &DiagnosticsFilterModel::setFilterFixedString);
+        connect(filter_severity, &QComboBox::currentIndexChanged, filter_model, [filter_model, filter_severity](int) {
+            filter_model->set_minimum_severity(filter_severity->currentData().toInt());
+        });
+
+        auto *diagnostics_table = new QTableView(this->diagnostics_widget);
+        diagnostics_table->setModel(filter_model);
+        diagnostics_table->setSortingEnabled(true);
+        diagnostics_table->sortByColumn(DiagnosticsModel::Column::Line, Qt::SortOrder::AscendingOrder);
+        diagnostics_table->setSelectionBehavior(QAbstractItemView::SelectionBehavior::SelectRows);
+        diagnostics_table->setEditTriggers(QAbstractItemView::EditTrigger::NoEditTriggers);
+        diagnostics_table->setWordWrap(false);
+        diagnostics_table->verticalHeader()->hide();
+        diagnostics_table->verticalHeader()->setDefaultSectionSize(diagnostics_table->fontMetrics().height() + 2);
+        // Fixed starting widths; resizing to contents would have to look at every row
+        auto table_metrics = diagnostics_table->fontMetrics();
+        auto *table_header = diagnostics_table->horizontalHeader();
+        table_header->setSectionResizeMode(QHeaderView::ResizeMode::Interactive);
+        table_header->resizeSection(DiagnosticsModel::Column::Line, table_metrics.horizontalAdvance("err:0000000  "));
+        table_header->resizeSection(DiagnosticsModel::Column::Severity, table_metrics.horizontalAdvance("Fatal error  "));
+        table_header->resizeSection(DiagnosticsModel::Column::Tag, table_metrics.horizontalAdvance("x") * 32);
+        table_header->setStretchLastSection(true);
+        diagnostics_table->setMinimumHeight(diagnostics_table->fontMetrics().height() * 8);
+        diagnostics_layout->addWidget(diagnostics_table);
+
+        this->diagnostics_widget->setLayout(diagnostics_layout);
+        console_layout->addWidget(this->diagnostics_widget);
+        connect(this->diagnostics, &DiagnosticsModel::counts_changed, this, &ConsoleDialog::update_diagnostics_title);
+        this->update_diagnostics_title();
 
         console_widget->setLayout(console_layout);
         console_widget->setSizePolicy(QSizePolicy::Policy::Fixed, QSizePolicy::Policy::Expanding);
     }
 
     ConsoleDialog::~ConsoleDialog() {
+        // Anything still running gets killed when its owner goes away
+        auto *owner = this->process_owner;
+        QMetaObject::invokeMethod(owner, [owner]() {
+            delete owner;
+        }, Qt::ConnectionType::BlockingQueuedConnection);
+
+        this->console_thread->quit();
+        this->console_thread->wait();
+    }
+
+    QProcess *ConsoleDialog::create_process() {
+        QProcess *process = nullptr;
+        auto *owner = this->process_owner;
+        QMetaObject::invokeMethod(owner, [owner, &process]() {
+            process = new QProcess(owner);
+        }, Qt::ConnectionType::BlockingQueuedConnection);
+        return process;
+    }
+
+    void ConsoleDialog::start_process(QProcess *process) {
+        QMetaObject::invokeMethod(process, [process]() {
+            process->start();
+        }, Qt::ConnectionType::AutoConnection);
+    }
 
+    bool ConsoleDialog::process_is_running(QProcess *process) {
+        bool running = false;
+        QMetaObject::invokeMethod(process, [process, &running]() {
+            running = process->state() == QProcess::ProcessState::Running;
+        }, process->thread() == QThread::currentThread() ? Qt::ConnectionType::DirectConnection : Qt::ConnectionType::BlockingQueuedConnection);
+        return running;
     }
 
-    void ConsoleDialog::attach_to_process(QProcess *process) {
-        this->stdout_box->attach_to_process(process, ConsoleBox::StandardOutput);
-        this->stderr_box->attach_to_process(process, ConsoleBox::StandardError);
+    void ConsoleDialog::kill_process(QProcess *process) {
+        QMetaObject::invokeMethod(process, [process]() {
+            process->kill();
+            process->waitForFinished(-1);
+        }, process->thread() == QThread::currentThread() ? Qt::ConnectionType::DirectConnection : Qt::ConnectionType::BlockingQueuedConnection);
+    }
+
+    void ConsoleDialog::wait_for_process(QProcess *process) {
+        QMetaObject::invokeMethod(process, [process]() {
+            process->waitForFinished(-1);
+        }, process->thread() == QThread::currentThread() ? Qt::ConnectionType::DirectConnection : Qt::ConnectionType::BlockingQueuedConnection);
+    }
+
+    void ConsoleDialog::destroy_process(QProcess *process) {
+        if(process != nullptr) {
+            process->deleteLater();
+        }
+    }
+
+    void ConsoleDialog::run_on_console_thread(std::function<void()> function, bool blocking) {
+        QMetaObject::invokeMethod(this->process_owner, std::move(function), blocking ? Qt::ConnectionType::BlockingQueuedConnection : Qt::ConnectionType::QueuedConnection);
+    }
+
+    void ConsoleDialog::show_output(const QByteArray &data, bool standard_error) {
+        (standard_error ? this->stderr_stream : this->stdout_stream)->ingest(data);
+        if(this->unified_stream != nullptr) {
+            this->unified_stream->ingest(data, standard_error ? ConsoleStream::StandardError : ConsoleStream::StandardOutput);
+        }
+    }
+
+    void ConsoleDialog::attach_to_process(QProcess *process, std::shared_ptr<QByteArray> output_copy, bool whole_lines) {
+        // Each channel is read once and handed to every stream that wants it. This is a direct connection so the output
+        // is read on the process's thread, not ours.
+        auto *stdout_stream = this->stdout_stream;
+        auto *stderr_stream = this->stderr_stream;
+        auto *unified_stream = this->unified_stream;
+
+        // When several processes share the console, only whole lines get handed over so theirs don't get mixed up
+        auto pending = whole_lines ? std::make_shared<std::array<QByteArray, 2>>() : nullptr;
+        auto deliver = [stdout_stream, stderr_stream, unified_stream, pending](QByteArray data, ConsoleStream::OutputChannel channel, bool finished) {
+            if(pending != nullptr) {
+                auto &buffer = (*pending)[channel == ConsoleStream::StandardError ? 1 : 0];
+                buffer.append(data);
+                auto end = finished ? buffer.size() : buffer.lastIndexOf('\n') + 1;
+                data = buffer.left(end);
+                buffer.remove(0, end);
+            }
+            if(data.isEmpty()) {
+                return;
+            }
+
+            (channel == ConsoleStream::StandardError ? stderr_stream : stdout_stream)->ingest(data);
+            if(unified_stream != nullptr) {
+                unified_stream->ingest(data, channel);
+            }
+        };
+
+        connect(process, &QProcess::readyReadStandardOutput, process, [process, deliver, output_copy]() {
+            auto data = process->readAllStandardOutput();
+            if(output_copy != nullptr) {
+                output_copy->append(data);
+            }
+            deliver(data, ConsoleStream::StandardOutput, false);
+        }, Qt::ConnectionType::DirectConnection);
+
+        connect(process, &QProcess::readyReadStandardError, process, [process, deliver]() {
+            deliver(process->readAllStandardError(), ConsoleStream::StandardError, false);
+        }, Qt::ConnectionType::DirectConnection);
+
+        // Whatever's left if the last line didn't end in a newline
+        if(whole_lines) {
+            connect(process, &QProcess::finished, process, [deliver]() {
+                deliver(QByteArray(), ConsoleStream::StandardOutput, true);
+                deliver(QByteArray(), ConsoleStream::StandardError, true);
+            }, Qt::ConnectionType::DirectConnection);
+        }
 
         // Have colors always on
         auto env = process->processEnvironment();
@@ -45,12 +253,22 @@ namespace SixShooter {
         process->setProcessEnvironment(env);
     }
 
+    void ConsoleDialog::update_diagnostics_title() {
+        auto errors = this->diagnostics->count(DiagnosticsParser::Severity::Error) + this->diagnostics->count(DiagnosticsParser::Severity::FatalError);
+        auto warnings = this->diagnostics->count(DiagnosticsParser::Severity::Warning);
+        auto pedantic = this->diagnostics->count(DiagnosticsParser::Severity::Pedantic);
+        this->diagnostics_widget->setTitle(QString("Diagnostics (%1 errors, %2 warnings, %3 pedantic)").arg(errors).arg(warnings).arg(pedantic));
+    }
+
     QWidget *ConsoleDialog::get_console_widget() {
         return this->console_widget;
     }
 
     void ConsoleDialog::reset_contents() {
-        this->stdout_box->reset_contents();
-        this->stderr_box->reset_contents();
+        this->stdout_stream->reset();
+        this->stderr_stream->reset();
+        if(this->unified_stream != nullptr) {
+            this->unified_stream->reset();
+        }
     }
 }
@@ -4,11 +4,16 @@
 #define SIX_SHOOTER_CONSOLE_DIALOG_HPP
 
 #include <QDialog>
+#include <functional>
+#include <memory>
 
 class QProcess;
+class QThread;
+class QGroupBox;
 
 namespace SixShooter {
-    class ConsoleBox;
+    class ConsoleStream;
+    class DiagnosticsModel;
 
     class ConsoleDialog : public QDialog {
         Q_OBJECT
@@ -18,14 +23,40 @@ namespace SixShooter {
 
     protected:
         ConsoleDialog();
-        void attach_to_process(QProcess *process);
+        // If output_copy is set, standard output is also appended to it (on the process's thread). Use whole_lines when
+        // more than one process is attached at a time.
+        void attach_to_process(QProcess *process, std::shared_ptr<QByteArray> output_copy = nullptr, bool whole_lines = false);
+
+        // Show output that was saved from an earlier run as if a process had just printed it. Safe to call from the
+        // console thread as well.
+        void show_output(const QByteArray &data, bool standard_error = false);
         void reset_contents();
         QWidget *get_console_widget();
 
+        // Processes made with create_process() live on the console thread so their output gets drained even while the
+        // GUI is busy. Only set them up directly; use these to run and stop them.
+        QProcess *create_process();
+        void start_process(QProcess *process);
+        bool process_is_running(QProcess *process);
+        void kill_process(QProcess *process);
+        void wait_for_process(QProcess *process);
+        void destroy_process(QProcess *process);
+
+        // Run something on the console thread after whatever's already waiting to run there. If blocking, wait for it.
+        void run_on_console_thread(std::function<void()> function, bool blocking = false);
+
     private:
-        ConsoleBox *stderr_box;
-        ConsoleBox *stdout_box;
+        ConsoleStream *stderr_stream;
+        ConsoleStream *stdout_stream;
+        ConsoleStream *unified_stream = nullptr;
         QWidget *console_widget;
+
+        DiagnosticsModel *diagnostics;
+        QGroupBox *diagnostics_widget;
+        void update_diagnostics_title();
+
+        QThread *console_thread;
+        QObject *process_owner;
     };
 }
 
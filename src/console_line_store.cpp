@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <algorithm>
+
+#include "console_line_store.hpp"
+
+namespace SixShooter {
+    void ConsoleLineStore::append(const std::vector<AnsiParser::Span> &spans) {
+        auto new_line = [this]() {
+            this->lines.emplace_back(Line { this->arena_base + this->arena.size(), 0, 0, this->span_base + this->spans.size() });
+        };
+
+        if(this->lines.empty()) {
+            new_line();
+        }
+
+        for(auto &span : spans) {
+            QStringView text = span.text;
+            auto text_length = text.size();
+            qsizetype start = 0;
+
+            while(true) {
+                auto newline = text.indexOf(u'\n', start);
+                auto end = newline == -1 ? text_length : newline;
+                auto length = static_cast<std::uint32_t>(end - start);
+
+                if(length > 0) {
+                    auto &line = this->lines.back();
+                    this->arena.append(text.utf16() + start, length);
+
+                    // Extend the last span if the style didn't change
+                    if(line.span_count > 0 && this->spans.back().style == span.style) {
+                        this->spans.back().length += length;
+                    }
+                    else {
+                        this->spans.emplace_back(Span { line.length, length, span.style });
+                        line.span_count++;
+                    }
+
+                    line.length += length;
+                    this->total_bytes += length * sizeof(char16_t);
+                    this->longest_line_length = std::max(this->longest_line_length, static_cast<std::size_t>(line.length));
+                }
+
+                if(newline == -1) {
+                    break;
+                }
+
+                new_line();
+                start = newline + 1;
+            }
+        }
+    }
+
+    void ConsoleLineStore::clear() {
+        this->arena.clear();
+        this->arena_base = 0;
+        this->spans.clear();
+        this->span_base = 0;
+        this->lines.clear();
+        this->longest_line_length = 0;
+        this->total_bytes = 0;
+    }
+
+    std::size_t ConsoleLineStore::trim(std::size_t max_lines, qint64 max_bytes) {
+        // Always keep the line we're writing to
+        std::size_t dropped = 0;
+        while(this->lines.size() > 1) {
+            bool over_lines = max_lines > 0 && this->lines.size() > max_lines;
+            bool over_bytes = max_bytes > 0 && this->total_bytes > max_bytes;
+            if(!over_lines && !over_bytes) {
+                break;
+            }
+
+            this->total_bytes -= this->lines.front().length * sizeof(char16_t);
+            this->lines.pop_front();
+            dropped++;
+        }
+
+        if(dropped > 0) {
+            this->compact();
+        }
+
+        return dropped;
+    }
+
+    void ConsoleLineStore::compact() {
+        auto &first = this->lines.front();
+
+        // Only move memory once at least half of it is unused so trimming stays amortized O(1) per line
+        auto unused_text = static_cast<std::size_t>(first.offset - this->arena_base);
+        if(unused_text > this->arena.size() / 2) {
+            this->arena.erase(0, unused_text);
+            this->arena_base = first.offset;
+        }
+
+        auto unused_spans = static_cast<std::size_t>(first.first_span - this->span_base);
+        if(unused_spans > this->spans.size() / 2) {
+            this->spans.erase(this->spans.begin(), this->spans.begin() + unused_spans);
+            this->span_base = first.first_span;
+        }
+    }
+
+    QStringView ConsoleLineStore::line_text(std::size_t line) const noexcept {
+        auto &l = this->lines[line];
+        return QStringView(this->arena.data() + (l.offset - this->arena_base), l.length);
+    }
+
+    std::pair<const ConsoleLineStore::Span *, std::size_t> ConsoleLineStore::line_spans(std::size_t line) const noexcept {
+        auto &l = this->lines[line];
+        return { this->spans.data() + (l.first_span - this->span_base), l.span_count };
+    }
+}
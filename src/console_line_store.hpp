@@ -0,0 +1,66 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SIX_SHOOTER_CONSOLE_LINE_STORE_HPP
+#define SIX_SHOOTER_CONSOLE_LINE_STORE_HPP
+
+#include <QStringView>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "ansi_parser.hpp"
+
+namespace SixShooter {
+    class ConsoleLineStore {
+    public:
+        // A styled run within a line; offset is relative to the start of the line
+        struct Span {
+            std::uint32_t offset;
+            std::uint32_t length;
+            AnsiParser::Style style;
+        };
+
+        void append(const std::vector<AnsiParser::Span> &spans);
+        void clear();
+
+        // Drop the oldest lines until we are within the given limits (0 means unlimited); returns the number of lines dropped
+        std::size_t trim(std::size_t max_lines, qint64 max_bytes);
+
+        std::size_t line_count() const noexcept {
+            return this->lines.size();
+        }
+        std::size_t longest_line() const noexcept {
+            return this->longest_line_length;
+        }
+        qint64 get_total_bytes() const noexcept {
+            return this->total_bytes;
+        }
+
+        QStringView line_text(std::size_t line) const noexcept;
+        std::pair<const Span *, std::size_t> line_spans(std::size_t line) const noexcept;
+
+    private:
+        struct Line {
+            std::uint64_t offset;
+            std::uint32_t length;
+            std::uint32_t span_count;
+            std::uint64_t first_span;
+        };
+
+        void compact();
+
+        // All text lives in one arena; offsets are absolute, so dropping old text only moves the base
+        std::u16string arena;
+        std::uint64_t arena_base = 0;
+
+        std::vector<Span> spans;
+        std::uint64_t span_base = 0;
+
+        std::deque<Line> lines;
+        std::size_t longest_line_length = 0;
+        qint64 total_bytes = 0;
+    };
+}
+
+#endif
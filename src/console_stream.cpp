@@ -0,0 +1,294 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <QFile>
+#include <QDir>
+#include <QDateTime>
+#include <QStandardPaths>
+#include <QGuiApplication>
+#include <QScreen>
+#include <QLocale>
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
+#include "console_stream.hpp"
+#include "settings.hpp"
+
+namespace SixShooter {
+    ConsoleStream::ConsoleStream(OutputChannel channel, QObject *parent) : QObject(parent), channel(channel) {
+        SixShooterSettings settings;
+        this->log_to_disk = settings.value("console_log_to_disk", false).toBool();
+
+        // Draw at the display's refresh rate, but keep it between 30 and 60 Hz
+        auto *screen = QGuiApplication::primaryScreen();
+        auto refresh_rate = screen != nullptr ? screen->refreshRate() : 60.0;
+        this->render_timer.setInterval(static_cast<int>(1000.0 / std::clamp(refresh_rate, 30.0, 60.0)));
+        this->render_timer.setSingleShot(true);
+        connect(&this->render_timer, &QTimer::timeout, this, &ConsoleStream::flush_output);
+    }
+
+    ConsoleStream::~ConsoleStream() = default;
+
+    void ConsoleStream::reset() {
+        {
+            std::lock_guard<std::mutex> lock(this->producer_mutex);
+            for(auto &parser : this->parsers) {
+                parser.reset();
+            }
+            this->receive_timer.invalidate();
+
+            this->session_start_ns = -1;
+            this->last_line_ns = 0;
+            this->last_source = -1;
+            std::fill(std::begin(this->at_line_start), std::end(this->at_line_start), true);
+            std::fill(std::begin(this->continued_line), std::end(this->continued_line), false);
+
+            // Start a new log file with the next output
+            this->log_file.reset();
+
+            this->generation++;
+        }
+
+        // Throw away anything that was already handed over
+        Batch batch;
+        while(this->ready.pop(batch)) {}
+
+        // A flush that was pending won't happen now, so let the next output schedule one
+        this->render_timer.stop();
+        this->flush_scheduled = false;
+
+        this->bytes_received = 0;
+        this->reads = 0;
+        this->largest_read = 0;
+        this->receive_time_ms = 0;
+        this->flushes = 0;
+        this->flush_time_ms = 0;
+
+        emit this->cleared();
+    }
+
+    void ConsoleStream::disable_log_to_disk() {
+        std::lock_guard<std::mutex> lock(this->producer_mutex);
+        this->log_to_disk = false;
+        this->log_file.reset();
+    }
+
+    void ConsoleStream::ingest(const QByteArray &data, OutputChannel source) {
+        // Take the time as soon as we have the data so the timestamps say when it was actually printed
+        auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+        Batch batch;
+        bool has_output;
+
+        {
+            std::lock_guard<std::mutex> lock(this->producer_mutex);
+
+            if(!this->receive_timer.isValid()) {
+                this->receive_timer.start();
+            }
+
+            auto parser_index = source == OutputChannel::StandardError ? 1 : 0;
+            this->parsers[parser_index].feed(data, batch.spans);
+
+            if(this->channel == OutputChannel::Unified) {
+                this->add_timestamps(batch.spans, source, now);
+
+                // Unified logs get the timestamped text rather than the raw output
+                QString text;
+                for(auto &span : batch.spans) {
+                    text += span.text;
+                }
+                this->write_log(text.toUtf8());
+            }
+            else {
+                this->write_log(data);
+            }
+
+            this->receive_time_ms = this->receive_timer.elapsed();
+
+            // Pushing while holding the lock keeps this a single producer even if two processes share the stream
+            has_output = !batch.spans.empty();
+            if(has_output) {
+                batch.generation = this->generation;
+                this->ready.push(std::move(batch));
+            }
+        }
+
+        this->bytes_received += data.size();
+        this->reads++;
+        if(data.size() > this->largest_read) {
+            this->largest_read = data.size();
+        }
+
+        // Wake up the GUI thread, but only once until it gets around to flushing
+        if(has_output && !this->flush_scheduled.exchange(true)) {
+            QMetaObject::invokeMethod(this, &ConsoleStream::schedule_flush, Qt::ConnectionType::QueuedConnection);
+        }
+    }
+
+    void ConsoleStream::add_timestamps(std::vector<AnsiParser::Span> &spans, OutputChannel source, qint64 now) {
+        if(this->session_start_ns < 0) {
+            this->session_start_ns = now;
+            this->last_line_ns = now;
+        }
+
+        auto source_index = source == OutputChannel::StandardError ? 1 : 0;
+        std::vector<AnsiParser::Span> timestamped;
+        timestamped.reserve(spans.size() * 2);
+
+        for(auto &span : spans) {
+            QStringView text = span.text;
+            auto length = text.size();
+            qsizetype start = 0;
+
+            while(start < length) {
+                // If the other source is in the middle of a line, break it so the two don't get mixed together
+                if(this->last_source != -1 && this->last_source != source_index && !this->at_line_start[this->last_source]) {
+                    timestamped.emplace_back(AnsiParser::Span { QStringLiteral("\n"), AnsiParser::Style() });
+                    this->at_line_start[this->last_source] = true;
+                    this->continued_line[this->last_source] = true;
+                }
+                this->last_source = source_index;
+
+                if(this->at_line_start[source_index]) {
+                    AnsiParser::Style prefix_style;
+                    QString delta;
+
+                    if(this->continued_line[source_index]) {
+                        delta = QStringLiteral("  (cont.)");
+                        prefix_style.flags |= AnsiParser::Style::Flags::Faint;
+                    }
+                    else {
+                        auto gap = now - this->last_line_ns;
+                        this->last_line_ns = now;
+                        delta = QString("+%1").arg(gap / 1000000000.0, 8, 'f', 3);
+
+                        if(gap >= VERY_SLOW_LINE_NS) {
+                            prefix_style.foreground = AnsiParser::palette_color(1);
+                        }
+                        else if(gap >= SLOW_LINE_NS) {
+                            prefix_style.foreground = AnsiParser::palette_color(3);
+                        }
+                        else {
+                            prefix_style.flags |= AnsiParser::Style::Flags::Faint;
+                        }
+                    }
+
+                    auto prefix = QString("[%1 %2 %3] ")
+                        .arg((now - this->session_start_ns) / 1000000000.0, 9, 'f', 3)
+                        .arg(delta)
+                        .arg(source_index == 1 ? "err" : "out");
+                    timestamped.emplace_back(AnsiParser::Span { prefix, prefix_style });
+
+                    this->at_line_start[source_index] = false;
+                    this->continued_line[source_index] = false;
+                }
+
+                auto newline = text.indexOf(u'\n', start);
+                auto end = newline == -1 ? length : newline + 1;
+                timestamped.emplace_back(AnsiParser::Span { text.mid(start, end - start).toString(), span.style });
+
+                if(newline == -1) {
+                    break;
+                }
+
+                this->at_line_start[source_index] = true;
+                start = end;
+            }
+        }
+
+        spans = std::move(timestamped);
+    }
+
+    void ConsoleStream::schedule_flush() {
+        if(!this->render_timer.isActive()) {
+            this->render_timer.start();
+        }
+    }
+
+    void ConsoleStream::flush_output() {
+        this->flush_scheduled = false;
+
+        // Merge runs that ended up with the same style (e.g. text split across reads)
+        std::uint64_t current_generation = this->generation;
+        std::vector<AnsiParser::Span> spans;
+        Batch batch;
+        while(this->ready.pop(batch)) {
+            if(batch.generation != current_generation) {
+                continue;
+            }
+            for(auto &span : batch.spans) {
+                if(!spans.empty() && spans.back().style == span.style) {
+                    spans.back().text += span.text;
+                }
+                else {
+                    spans.emplace_back(std::move(span));
+                }
+            }
+        }
+
+        if(spans.empty()) {
+            return;
+        }
+
+        this->flushes++;
+        emit this->output_ready(spans);
+    }
+
+    void ConsoleStream::record_flush_time(qint64 ms) {
+        this->flush_time_ms += ms;
+    }
+
+    ConsoleStream::Statistics ConsoleStream::get_statistics() const noexcept {
+        Statistics statistics;
+        statistics.bytes_received = this->bytes_received;
+        statistics.reads = this->reads;
+        statistics.largest_read = this->largest_read;
+        statistics.flushes = this->flushes;
+        statistics.receive_time_ms = this->receive_time_ms;
+        statistics.flush_time_ms = this->flush_time_ms;
+        return statistics;
+    }
+
+    QString ConsoleStream::get_statistics_summary() const {
+        auto statistics = this->get_statistics();
+        auto seconds = std::max(statistics.receive_time_ms, static_cast<qint64>(1)) / 1000.0;
+        auto locale = QLocale();
+        return QString("Received %1 in %2 reads (%3/s), drawn in %4 frames (%5 ms)")
+            .arg(locale.formattedDataSize(statistics.bytes_received))
+            .arg(statistics.reads)
+            .arg(locale.formattedDataSize(static_cast<qint64>(statistics.bytes_received / seconds)))
+            .arg(statistics.flushes)
+            .arg(statistics.flush_time_ms);
+    }
+
+    void ConsoleStream::write_log(const QByteArray &data) {
+        if(!this->log_to_disk) {
+            return;
+        }
+
+        if(this->log_file == nullptr) {
+            auto log_directory = QDir(QStandardPaths::writableLocation(QStandardPaths::StandardLocation::AppDataLocation)).filePath("logs");
+            QDir().mkpath(log_directory);
+
+            const char *suffix = "-output.log";
+            if(this->channel == OutputChannel::StandardError) {
+                suffix = "-errors.log";
+            }
+            else if(this->channel == OutputChannel::Unified) {
+                suffix = "-unified.log";
+            }
+
+            auto name = QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss-zzz") + suffix;
+            this->log_file = std::make_unique<QFile>(QDir(log_directory).filePath(name));
+            if(!this->log_file->open(QIODevice::OpenModeFlag::WriteOnly | QIODevice::OpenModeFlag::Append)) {
+                std::fprintf(stderr, "Failed to open %s for writing\n", this->log_file->fileName().toLocal8Bit().data());
+                this->log_to_disk = false;
+                this->log_file.reset();
+                return;
+            }
+        }
+
+        this->log_file->write(data);
+    }
+}
@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SIX_SHOOTER_CONSOLE_STREAM_HPP
+#define SIX_SHOOTER_CONSOLE_STREAM_HPP
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "ansi_parser.hpp"
+#include "spsc_queue.hpp"
+
+class QFile;
+
+namespace SixShooter {
+    // Output from one channel of a child process (or both, timestamped, for a unified stream). Logging and parsing happen
+    // on whichever thread the process lives on; the parsed spans are handed over to the GUI thread through a lock-free
+    // queue and drawn once per frame.
+    class ConsoleStream : public QObject {
+        Q_OBJECT
+    public:
+        enum OutputChannel {
+            StandardOutput,
+            StandardError,
+            Unified
+        };
+
+        // Lines that come this long after the previous one get highlighted in unified streams
+        static constexpr qint64 SLOW_LINE_NS = 1000000000;
+        static constexpr qint64 VERY_SLOW_LINE_NS = 10000000000;
+
+        // Raw throughput counters, updated as output is read and as it gets drawn
+        struct Statistics {
+            qint64 bytes_received = 0;
+            qint64 reads = 0;
+            qint64 largest_read = 0;
+            qint64 flushes = 0;
+            qint64 receive_time_ms = 0;
+            qint64 flush_time_ms = 0;
+        };
+
+        ConsoleStream(OutputChannel channel, QObject *parent = nullptr);
+        ~ConsoleStream() override;
+
+        // Safe to call from any one producer thread at a time. The source only matters for unified streams.
+        void ingest(const QByteArray &data, OutputChannel source);
+        void ingest(const QByteArray &data) {
+            this->ingest(data, this->channel);
+        }
+
+        // GUI thread only
+        void reset();
+
+        // Turn off writing to disk (on by default with the console_log_to_disk setting) for streams nobody looks at
+        // directly, e.g. the separate output and error streams while a unified one is shown. Set before any output.
+        void disable_log_to_disk();
+
+        OutputChannel get_channel() const noexcept {
+            return this->channel;
+        }
+        Statistics get_statistics() const noexcept;
+        QString get_statistics_summary() const;
+
+        // Called by the views once they finish drawing a flush
+        void record_flush_time(qint64 ms);
+
+    signals:
+        // Emitted at most once per frame with everything read since the last one
+        void output_ready(const std::vector<AnsiParser::Span> &spans);
+        void cleared();
+
+    private:
+        struct Batch {
+            std::uint64_t generation = 0;
+            std::vector<AnsiParser::Span> spans;
+        };
+
+        void schedule_flush();
+        void flush_output();
+        void write_log(const QByteArray &data);
+        void add_timestamps(std::vector<AnsiParser::Span> &spans, OutputChannel source, qint64 now);
+
+        OutputChannel channel;
+
+        // Producer side; the mutex is only ever contended when resetting
+        std::mutex producer_mutex;
+        AnsiParser parsers[2];
+        QElapsedTimer receive_timer;
+
+        // Unified streams only: when the session started, when the last line started, and where each source left off
+        qint64 session_start_ns = -1;
+        qint64 last_line_ns = 0;
+        int last_source = -1;
+        bool at_line_start[2] = { true, true };
+        bool continued_line[2] = { false, false };
+        bool log_to_disk;
+        std::unique_ptr<QFile> log_file;
+
+        // Hand-off to the GUI thread. Batches from before the last reset are thrown away.
+        SpscQueue<Batch> ready;
+        std::atomic<std::uint64_t> generation { 0 };
+        std::atomic<bool> flush_scheduled { false };
+        QTimer render_timer;
+
+        std::atomic<qint64> bytes_received { 0 };
+        std::atomic<qint64> reads { 0 };
+        std::atomic<qint64> largest_read { 0 };
+        std::atomic<qint64> receive_time_ms { 0 };
+        qint64 flushes = 0;
+        qint64 flush_time_ms = 0;
+    };
+}
+
+#endif
@@ -0,0 +1,142 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <QFontDatabase>
+#include <QApplication>
+#include <QStyle>
+#include <QScrollBar>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QElapsedTimer>
+#include <algorithm>
+
+#include "console_view.hpp"
+#include "console_box.hpp"
+#include "console_stream.hpp"
+#include "settings.hpp"
+
+namespace SixShooter {
+    ConsoleView::ConsoleView(QWidget *parent) : QAbstractScrollArea(parent) {
+        auto font = QFontDatabase::systemFont(QFontDatabase::FixedFont);
+        this->setFont(font);
+        this->viewport()->setFont(font);
+
+        auto font_metrics = QFontMetrics(font);
+        this->line_height = font_metrics.height();
+        this->character_width = font_metrics.horizontalAdvance(QChar('M'));
+
+        // Same size as ConsoleBox: 80 columns by 24 rows
+        auto margins = this->contentsMargins();
+        auto *style = qApp->style();
+        this->setVerticalScrollBarPolicy(Qt::ScrollBarPolicy::ScrollBarAlwaysOn);
+        this->setFixedWidth(font_metrics.horizontalAdvance("It seems that this whole sentence is exactly eighty characters in string length.") + style->pixelMetric(QStyle::PM_ScrollBarExtent) + this->frameWidth() * 2 + margins.left() + margins.right());
+        this->setMinimumHeight(this->line_height * 24 + this->frameWidth() * 2 + margins.top() + margins.bottom());
+
+        auto palette = this->viewport()->palette();
+        palette.setColor(QPalette::ColorRole::Base, QColor(AnsiParser::DEFAULT_BACKGROUND));
+        palette.setColor(QPalette::ColorRole::Text, QColor(AnsiParser::DEFAULT_FOREGROUND));
+        this->viewport()->setPalette(palette);
+        this->viewport()->setAutoFillBackground(false);
+
+        this->verticalScrollBar()->setSingleStep(1);
+        this->horizontalScrollBar()->setSingleStep(this->character_width);
+
+        SixShooterSettings settings;
+        this->max_lines = settings.value("console_scrollback_lines", ConsoleBox::DEFAULT_SCROLLBACK_LINES).toULongLong();
+        this->max_bytes = settings.value("console_scrollback_bytes", ConsoleBox::DEFAULT_SCROLLBACK_BYTES).toLongLong();
+    }
+
+    void ConsoleView::set_stream(ConsoleStream *stream) {
+        connect(stream, &ConsoleStream::output_ready, this, &ConsoleView::append_output);
+        connect(stream, &ConsoleStream::cleared, this, &ConsoleView::reset_contents);
+        this->stream = stream;
+    }
+
+    void ConsoleView::reset_contents() {
+        this->lines.clear();
+        this->update_scroll_bars();
+        this->viewport()->update();
+    }
+
+    void ConsoleView::append_output(const std::vector<AnsiParser::Span> &spans) {
+        QElapsedTimer flush_timer;
+        flush_timer.start();
+
+        auto *scroll_bar = this->verticalScrollBar();
+        bool at_bottom = scroll_bar->value() == scroll_bar->maximum();
+
+        this->lines.append(spans);
+        auto dropped = this->lines.trim(this->max_lines, this->max_bytes);
+        this->update_scroll_bars();
+
+        // Follow the output if we were already at the bottom; otherwise keep the same lines in view
+        if(at_bottom) {
+            scroll_bar->setValue(scroll_bar->maximum());
+        }
+        else {
+            scroll_bar->setValue(scroll_bar->value() - static_cast<int>(dropped));
+        }
+
+        this->viewport()->update();
+
+        this->stream->record_flush_time(flush_timer.elapsed());
+        this->setToolTip(this->stream->get_statistics_summary());
+    }
+
+    void ConsoleView::update_scroll_bars() {
+        auto visible_lines = std::max(this->viewport()->height() / this->line_height, 1);
+        auto line_count = static_cast<int>(this->lines.line_count());
+
+        auto *vertical = this->verticalScrollBar();
+        vertical->setPageStep(visible_lines);
+        vertical->setRange(0, std::max(line_count - visible_lines, 0));
+
+        auto *horizontal = this->horizontalScrollBar();
+        auto content_width = static_cast<int>(this->lines.longest_line()) * this->character_width;
+        horizontal->setPageStep(this->viewport()->width());
+        horizontal->setRange(0, std::max(content_width - this->viewport()->width(), 0));
+    }
+
+    void ConsoleView::resizeEvent(QResizeEvent *event) {
+        QAbstractScrollArea::resizeEvent(event);
+        this->update_scroll_bars();
+    }
+
+    void ConsoleView::paintEvent(QPaintEvent *event) {
+        QPainter painter(this->viewport());
+        painter.fillRect(event->rect(), QColor(AnsiParser::DEFAULT_BACKGROUND));
+
+        auto line_count = this->lines.line_count();
+        auto first_line = static_cast<std::size_t>(this->verticalScrollBar()->value());
+        auto x_offset = -this->horizontalScrollBar()->value();
+        auto ascent = this->fontMetrics().ascent();
+        auto base_font = this->font();
+
+        // Only the lines that are actually visible get drawn
+        int y = 0;
+        for(auto line = first_line; line < line_count && y < this->viewport()->height(); line++, y += this->line_height) {
+            auto text = this->lines.line_text(line);
+            auto [spans, span_count] = this->lines.line_spans(line);
+
+            int x = x_offset;
+            for(std::size_t s = 0; s < span_count; s++) {
+                auto &span = spans[s];
+                auto span_text = text.mid(span.offset, span.length).toString();
+
+                auto font = base_font;
+                font.setBold(span.style.flags & AnsiParser::Style::Flags::Bold);
+                font.setUnderline(span.style.flags & AnsiParser::Style::Flags::Underline);
+                auto width = QFontMetrics(font).horizontalAdvance(span_text);
+
+                if(span.style.background != AnsiParser::Style::DEFAULT_COLOR) {
+                    painter.fillRect(x, y, width, this->line_height, span.style.background_color());
+                }
+
+                painter.setFont(font);
+                painter.setPen(span.style.foreground_color());
+                painter.drawText(x, y + ascent, span_text);
+
+                x += width;
+            }
+        }
+    }
+}
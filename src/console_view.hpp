@@ -0,0 +1,41 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SIX_SHOOTER_CONSOLE_VIEW_HPP
+#define SIX_SHOOTER_CONSOLE_VIEW_HPP
+
+#include <QAbstractScrollArea>
+#include <vector>
+
+#include "console_line_store.hpp"
+
+namespace SixShooter {
+    class ConsoleStream;
+
+    // Console widget that only draws the lines in view, for logs too big for ConsoleBox to handle smoothly
+    class ConsoleView : public QAbstractScrollArea {
+        Q_OBJECT
+    public:
+        ConsoleView(QWidget *parent = nullptr);
+        void set_stream(ConsoleStream *stream);
+        void reset_contents();
+
+    protected:
+        void paintEvent(QPaintEvent *event) override;
+        void resizeEvent(QResizeEvent *event) override;
+
+    private:
+        void append_output(const std::vector<AnsiParser::Span> &spans);
+        void update_scroll_bars();
+
+        ConsoleStream *stream = nullptr;
+        ConsoleLineStore lines;
+
+        std::size_t max_lines;
+        qint64 max_bytes;
+
+        int line_height;
+        int character_width;
+    };
+}
+
+#endif
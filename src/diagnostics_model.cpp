@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <QColor>
+#include <algorithm>
+
+#include "diagnostics_model.hpp"
+#include "console_stream.hpp"
+
+namespace SixShooter {
+    DiagnosticsModel::DiagnosticsModel(QObject *parent) : QAbstractTableModel(parent) {
+        this->parsers.reserve(2);
+    }
+
+    void DiagnosticsModel::attach_to_stream(ConsoleStream *stream) {
+        // Each stream gets its own parser since lines from stdout and stderr can be interleaved
+        auto index = this->parsers.size();
+        this->parsers.emplace_back(stream, DiagnosticsParser());
+
+        connect(stream, &ConsoleStream::output_ready, this, [this, stream, index](const std::vector<AnsiParser::Span> &spans) {
+            this->add_output(stream, this->parsers[index].second, spans);
+        });
+        connect(stream, &ConsoleStream::cleared, this, &DiagnosticsModel::reset_contents);
+    }
+
+    void DiagnosticsModel::reset_contents() {
+        for(auto &p : this->parsers) {
+            p.second.reset();
+        }
+
+        if(this->entries.empty()) {
+            return;
+        }
+
+        this->beginResetModel();
+        this->entries.clear();
+        std::fill(std::begin(this->counts), std::end(this->counts), 0);
+        this->endResetModel();
+        emit this->counts_changed();
+    }
+
+    void DiagnosticsModel::add_output(ConsoleStream *stream, DiagnosticsParser &parser, const std::vector<AnsiParser::Span> &spans) {
+        std::vector<DiagnosticsParser::Diagnostic> found;
+        for(auto &span : spans) {
+            parser.feed(span.text, found);
+        }
+
+        if(found.empty()) {
+            return;
+        }
+
+        auto first = static_cast<int>(this->entries.size());
+        this->beginInsertRows(QModelIndex(), first, first + static_cast<int>(found.size()) - 1);
+        for(auto &diagnostic : found) {
+            this->counts[diagnostic.severity]++;
+            this->entries.emplace_back(Entry { std::move(diagnostic), stream });
+        }
+        this->endInsertRows();
+        emit this->counts_changed();
+    }
+
+    int DiagnosticsModel::rowCount(const QModelIndex &parent) const {
+        return parent.isValid() ? 0 : static_cast<int>(this->entries.size());
+    }
+
+    int DiagnosticsModel::columnCount(const QModelIndex &parent) const {
+        return parent.isValid() ? 0 : Column::ColumnCount;
+    }
+
+    QVariant DiagnosticsModel::data(const QModelIndex &index, int role) const {
+        if(!index.isValid() || index.row() >= static_cast<int>(this->entries.size())) {
+            return QVariant();
+        }
+
+        auto &entry = this->entries[index.row()];
+        auto &diagnostic = entry.diagnostic;
+
+        switch(role) {
+            case Qt::DisplayRole:
+                switch(index.column()) {
+                    case Column::Line:
+                        return QString("%1:%2").arg(entry.stream->get_channel() == ConsoleStream::StandardError ? "err" : "out").arg(diagnostic.line + 1);
+                    case Column::Severity:
+                        return DiagnosticsParser::severity_name(diagnostic.severity);
+                    case Column::Tag:
+                        return diagnostic.tag;
+                    case Column::Message:
+                        return diagnostic.message;
+                }
+                break;
+
+            // Sort by the actual values rather than the display strings
+            case Qt::UserRole:
+                switch(index.column()) {
+                    case Column::Line:
+                        return diagnostic.line;
+                    case Column::Severity:
+                        return static_cast<int>(diagnostic.severity);
+                    case Column::Tag:
+                        return diagnostic.tag;
+                    case Column::Message:
+                        return diagnostic.message;
+                }
+                break;
+
+            case Qt::ForegroundRole:
+                if(index.column() == Column::Severity) {
+                    switch(diagnostic.severity) {
+                        case DiagnosticsParser::Severity::Pedantic:
+                            return QColor(0x7F7F00);
+                        case DiagnosticsParser::Severity::Warning:
+                            return QColor(0xBFBF00);
+                        case DiagnosticsParser::Severity::Error:
+                        case DiagnosticsParser::Severity::FatalError:
+                            return QColor(0xFF0000);
+                    }
+                }
+                break;
+
+            case Qt::ToolTipRole:
+                return diagnostic.message;
+        }
+
+        return QVariant();
+    }
+
+    QVariant DiagnosticsModel::headerData(int section, Qt::Orientation orientation, int role) const {
+        if(orientation != Qt::Orientation::Horizontal || role != Qt::DisplayRole) {
+            return QVariant();
+        }
+
+        switch(section) {
+            case Column::Line:
+                return "Line";
+            case Column::Severity:
+                return "Severity";
+            case Column::Tag:
+                return "Tag";
+            case Column::Message:
+                return "Message";
+        }
+
+        return QVariant();
+    }
+
+    DiagnosticsFilterModel::DiagnosticsFilterModel(QObject *parent) : QSortFilterProxyModel(parent) {
+        this->setSortRole(Qt::UserRole);
+        this->setFilterKeyColumn(-1);
+        this->setFilterCaseSensitivity(Qt::CaseSensitivity::CaseInsensitive);
+    }
+
+    void DiagnosticsFilterModel::set_minimum_severity(int severity) {
+        this->minimum_severity = severity;
+        this->invalidateFilter();
+    }
+
+    bool DiagnosticsFilterModel::filterAcceptsRow(int source_row, const QModelIndex &source_parent) const {
+        auto severity = this->sourceModel()->index(source_row, DiagnosticsModel::Column::Severity, source_parent).data(Qt::UserRole).toInt();
+        if(severity < this->minimum_severity) {
+            return false;
+        }
+        return QSortFilterProxyModel::filterAcceptsRow(source_row, source_parent);
+    }
+}
@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SIX_SHOOTER_DIAGNOSTICS_MODEL_HPP
+#define SIX_SHOOTER_DIAGNOSTICS_MODEL_HPP
+
+#include <QAbstractTableModel>
+#include <QSortFilterProxyModel>
+#include <vector>
+
+#include "ansi_parser.hpp"
+#include "diagnostics_parser.hpp"
+
+namespace SixShooter {
+    class ConsoleStream;
+
+    class DiagnosticsModel : public QAbstractTableModel {
+        Q_OBJECT
+    public:
+        enum Column {
+            Line,
+            Severity,
+            Tag,
+            Message,
+
+            ColumnCount
+        };
+
+        DiagnosticsModel(QObject *parent = nullptr);
+        void attach_to_stream(ConsoleStream *stream);
+        void reset_contents();
+
+        std::size_t count(DiagnosticsParser::Severity severity) const noexcept {
+            return this->counts[severity];
+        }
+
+        int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+        int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+        QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+        QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    signals:
+        void counts_changed();
+
+    private:
+        struct Entry {
+            DiagnosticsParser::Diagnostic diagnostic;
+            ConsoleStream *stream;
+        };
+
+        void add_output(ConsoleStream *stream, DiagnosticsParser &parser, const std::vector<AnsiParser::Span> &spans);
+
+        std::vector<Entry> entries;
+        std::vector<std::pair<ConsoleStream *, DiagnosticsParser>> parsers;
+        std::size_t counts[DiagnosticsParser::Severity::FatalError + 1] = {};
+    };
+
+    // Sorting plus a text filter over every column and a minimum severity
+    class DiagnosticsFilterModel : public QSortFilterProxyModel {
+        Q_OBJECT
+    public:
+        DiagnosticsFilterModel(QObject *parent = nullptr);
+        void set_minimum_severity(int severity);
+
+    protected:
+        bool filterAcceptsRow(int source_row, const QModelIndex &source_parent) const override;
+
+    private:
+        int minimum_severity = DiagnosticsParser::Severity::Pedantic;
+    };
+}
+
+#endif
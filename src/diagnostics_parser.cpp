@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <QRegularExpression>
+
+#include "diagnostics_parser.hpp"
+
+namespace SixShooter {
+    static const struct {
+        const char16_t *prefix;
+        DiagnosticsParser::Severity severity;
+    } PREFIXES[] = {
+        // Longest first so "fatal error" isn't taken for "error", etc.
+        { u"fatal error", DiagnosticsParser::Severity::FatalError },
+        { u"pedantic warning", DiagnosticsParser::Severity::Pedantic },
+        { u"warning (minor)", DiagnosticsParser::Severity::Pedantic },
+        { u"warning", DiagnosticsParser::Severity::Warning },
+        { u"error", DiagnosticsParser::Severity::Error }
+    };
+
+    const char *DiagnosticsParser::severity_name(Severity severity) noexcept {
+        switch(severity) {
+            case Severity::Pedantic:
+                return "Pedantic";
+            case Severity::Warning:
+                return "Warning";
+            case Severity::Error:
+                return "Error";
+            case Severity::FatalError:
+                return "Fatal error";
+        }
+        return "Unknown";
+    }
+
+    void DiagnosticsParser::reset() {
+        this->partial_line.clear();
+        this->line_number = 0;
+    }
+
+    void DiagnosticsParser::feed(QStringView text, std::vector<Diagnostic> &diagnostics) {
+        qsizetype start = 0;
+        while(true) {
+            auto newline = text.indexOf(u'\n', start);
+            if(newline == -1) {
+                this->partial_line += text.mid(start);
+                break;
+            }
+
+            // Only copy if the line started in an earlier chunk
+            if(this->partial_line.isEmpty()) {
+                this->parse_line(text.mid(start, newline - start), diagnostics);
+            }
+            else {
+                this->partial_line += text.mid(start, newline - start);
+                this->parse_line(this->partial_line, diagnostics);
+                this->partial_line.clear();
+            }
+
+            this->line_number++;
+            start = newline + 1;
+        }
+    }
+
+    void DiagnosticsParser::parse_line(QStringView line, std::vector<Diagnostic> &diagnostics) {
+        line = line.trimmed();
+
+        // Cheap check first; almost every line is not a diagnostic
+        if(line.isEmpty()) {
+            return;
+        }
+        auto first = line.front().toLower();
+        if(first != u'w' && first != u'e' && first != u'f' && first != u'p') {
+            return;
+        }
+
+        for(auto &p : PREFIXES) {
+            auto prefix = QStringView(p.prefix);
+            if(!line.startsWith(prefix, Qt::CaseSensitivity::CaseInsensitive)) {
+                continue;
+            }
+
+            auto rest = line.mid(prefix.size());
+            if(!rest.startsWith(u':')) {
+                continue;
+            }
+            rest = rest.mid(1).trimmed();
+
+            // Messages about a specific tag look like "path\to\tag.class: message"; otherwise look for any tag path in the message
+            static const QRegularExpression tag_prefix(QStringLiteral(R"(^([^:\s][^:]*\.[a-z_]+):\s+)"));
+            static const QRegularExpression tag_anywhere(QStringLiteral(R"(([\w\-.~ ]+[\\/][\w\-.~ \\/]*\.[a-z_]+))"));
+
+            Diagnostic diagnostic;
+            diagnostic.severity = p.severity;
+            diagnostic.line = this->line_number;
+
+            auto rest_string = rest.toString();
+            auto match = tag_prefix.match(rest_string);
+            if(match.hasMatch()) {
+                diagnostic.tag = match.captured(1);
+                diagnostic.message = rest_string.mid(match.capturedLength(0));
+            }
+            else {
+                diagnostic.message = rest_string;
+                auto anywhere = tag_anywhere.match(rest_string);
+                if(anywhere.hasMatch()) {
+                    diagnostic.tag = anywhere.captured(1).trimmed();
+                }
+            }
+
+            diagnostics.emplace_back(std::move(diagnostic));
+            return;
+        }
+    }
+}
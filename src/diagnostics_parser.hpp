@@ -0,0 +1,41 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SIX_SHOOTER_DIAGNOSTICS_PARSER_HPP
+#define SIX_SHOOTER_DIAGNOSTICS_PARSER_HPP
+
+#include <QString>
+#include <vector>
+
+namespace SixShooter {
+    // Picks out Invader's warning and error lines as output comes in. Only the unfinished last line is kept around, so
+    // the log is never rescanned.
+    class DiagnosticsParser {
+    public:
+        enum Severity {
+            Pedantic,
+            Warning,
+            Error,
+            FatalError
+        };
+
+        struct Diagnostic {
+            Severity severity;
+            QString tag;
+            QString message;
+            qint64 line;
+        };
+
+        void feed(QStringView text, std::vector<Diagnostic> &diagnostics);
+        void reset();
+
+        static const char *severity_name(Severity severity) noexcept;
+
+    private:
+        void parse_line(QStringView line, std::vector<Diagnostic> &diagnostics);
+
+        QString partial_line;
+        qint64 line_number = 0;
+    };
+}
+
+#endif
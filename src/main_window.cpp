@@ -18,9 +18,13 @@
 #include "map_builder.hpp"
 #include "main_window.hpp"
 #include "map_extractor.hpp"
+#include "map_extraction_queue.hpp"
+#include "map_reader.hpp"
+#include "maps_browser.hpp"
 #include "settings_editor.hpp"
 #include "tag_bludgeoner.hpp"
 #include "settings.hpp"
+#include "tag_index_service.hpp"
 
 #ifdef _WIN32
 #include "theme.hpp"
@@ -34,10 +38,19 @@ namespace SixShooter {
         Theme::set_win32_theme();
         #endif
 
+        // Keeps track of what's in the tags directories from here on
+        this->tag_index = new TagIndexService(this);
+
+        // Remembers what was found out about maps opened before
+        this->map_info_cache = std::make_unique<MapInfoCache>();
+
         // Reload these
         if(!this->reload_settings()) {
             this->start_settings_editor();
         }
+        else {
+            this->tag_index->set_directories(this->tags_directories, this->data_directory);
+        }
 
         // Set up the GUI
         auto *window_widget = new QWidget(this);
@@ -52,6 +65,10 @@ namespace SixShooter {
             connect(map_builder, &QPushButton::clicked, this, &MainWindow::start_map_builder);
             map_building_layout->addWidget(map_builder);
 
+            auto *maps_browser = new QPushButton("Browse maps", map_building_box);
+            connect(maps_browser, &QPushButton::clicked, this, &MainWindow::start_maps_browser);
+            map_building_layout->addWidget(maps_browser);
+
             map_building_box->setSizePolicy(QSizePolicy::Policy::Expanding, QSizePolicy::Policy::Fixed);
             map_building_box->setLayout(map_building_layout);
             window_layout->addWidget(map_building_box);
@@ -74,6 +91,10 @@ namespace SixShooter {
             connect(tag_extractor, &QPushButton::clicked, this, &MainWindow::start_tag_extractor);
             tag_editing_layout->addWidget(tag_extractor);
 
+            auto *extraction_queue = new QPushButton("Extract tags from several maps", tag_editing_box);
+            connect(extraction_queue, &QPushButton::clicked, this, &MainWindow::start_extraction_queue);
+            tag_editing_layout->addWidget(extraction_queue);
+
             auto *tag_bludgeoner = new QPushButton("Bludgeon tags", tag_editing_box);
             connect(tag_bludgeoner, &QPushButton::clicked, this, &MainWindow::start_tag_bludgeoner);
             tag_editing_layout->addWidget(tag_bludgeoner);
@@ -148,27 +169,58 @@ namespace SixShooter {
         qfd.setDirectory(std::filesystem::absolute(this->maps_directory).string().c_str());
 
         if(qfd.exec()) {
-            // Check if it's protected
-            QProcess process;
-            process.setProgram(this->executable_path("invader-info").string().c_str());
-            QStringList arguments;
-            arguments << "--type" << "is_protected";
-            arguments << qfd.selectedFiles()[0];
-            process.setArguments(arguments);
-            process.start();
-            process.waitForFinished(-1);
-
-            if(process.exitCode() == 1) {
-                QMessageBox warning;
-                warning.setWindowTitle("Unable to open the map");
-                warning.setText("This map appears to be invalid and cannot be opened.");
-                warning.setIcon(QMessageBox::Icon::Critical);
-                warning.exec();
-                return;
+            // Check if it's protected, unless we already know from the last time it was opened
+            auto map_path = qfd.selectedFiles()[0];
+            auto key = MapInfoCache::make_key(map_path.toStdString());
+            auto protection = MapInfoCache::Protection::Unknown;
+            if(key.has_value()) {
+                auto cached = this->map_info_cache->find(*key);
+                if(cached.has_value()) {
+                    protection = cached->protection;
+                }
             }
 
-            auto result = QString(process.readAllStandardOutput()).trimmed().toInt();
-            if(result == 1) {
+            // Reading the map directly is much quicker than asking invader-info, if it's a map that can be read
+            if(protection == MapInfoCache::Protection::Unknown) {
+                MapReader reader(map_path.toStdString());
+                if(reader.is_open()) {
+                    protection = reader.is_protected() ? MapInfoCache::Protection::Protected : MapInfoCache::Protection::Unprotected;
+                    if(key.has_value()) {
+                        this->map_info_cache->set_protection(*key, protection);
+                    }
+                }
+            }
+
+            if(protection == MapInfoCache::Protection::Unknown) {
+                QProcess process;
+                process.setProgram(this->executable_path("invader-info").string().c_str());
+                QStringList arguments;
+                arguments << "--type" << "is_protected";
+                arguments << map_path;
+                process.setArguments(arguments);
+                process.start();
+                process.waitForFinished(-1);
+
+                if(process.exitCode() == 1) {
+                    QMessageBox warning;
+                    warning.setWindowTitle("Unable to open the map");
+                    warning.setText("This map appears to be invalid and cannot be opened.");
+                    warning.setIcon(QMessageBox::Icon::Critical);
+                    warning.exec();
+                    return;
+                }
+
+                bool ok;
+                auto result = QString(process.readAllStandardOutput()).trimmed().toInt(&ok);
+                protection = result == 1 ? MapInfoCache::Protection::Protected : MapInfoCache::Protection::Unprotected;
+
+                // Only remember answers we actually got
+                if(ok && process.exitStatus() == QProcess::ExitStatus::NormalExit && key.has_value()) {
+                    this->map_info_cache->set_protection(*key, protection);
+                }
+            }
+
+            if(protection == MapInfoCache::Protection::Protected) {
                 QMessageBox warning;
                 warning.setWindowTitle("Map appears protected");
                 warning.setText("This map appears to be protected/corrupted. Extracting it in this state is not advised.\n\nAre you sure you want to open it?");
@@ -179,10 +231,18 @@ namespace SixShooter {
                 }
             }
 
-            MapExtractor(this, qfd.selectedFiles()[0].toStdString()).exec();
+            MapExtractor(this, map_path.toStdString()).exec();
         }
     }
 
+    void MainWindow::start_extraction_queue() {
+        MapExtractionQueue(this).exec();
+    }
+
+    void MainWindow::start_maps_browser() {
+        MapsBrowser(this).exec();
+    }
+
     void MainWindow::start_map_builder() {
         MapBuilder(this).exec();
     }
@@ -257,6 +317,7 @@ namespace SixShooter {
 
     void MainWindow::start_settings_editor() {
         do { SettingsEditor(this, !this->isVisible()).exec(); } while (!this->reload_settings());
+        this->tag_index->set_directories(this->tags_directories, this->data_directory);
     }
 
     std::vector<std::filesystem::path> MainWindow::get_tags_directories() const {
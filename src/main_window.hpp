@@ -5,11 +5,16 @@
 
 #include <QMainWindow>
 #include <filesystem>
+#include <memory>
 #include <vector>
 
+#include "map_info_cache.hpp"
+
 class QPushButton;
 
 namespace SixShooter {
+    class TagIndexService;
+
     class MainWindow : public QMainWindow {
         Q_OBJECT
         
@@ -27,6 +32,12 @@ namespace SixShooter {
         const std::filesystem::path &get_data_directory() const noexcept {
             return this->data_directory;
         }
+        TagIndexService *get_tag_index() const noexcept {
+            return this->tag_index;
+        }
+        MapInfoCache *get_map_info_cache() const noexcept {
+            return this->map_info_cache.get();
+        }
         
         static bool invader_path_is_valid(const std::filesystem::path &path);
         
@@ -41,7 +52,9 @@ namespace SixShooter {
         void start_about();
         
         void start_map_builder();
+        void start_maps_browser();
         void start_tag_extractor();
+        void start_extraction_queue();
         void start_settings_editor();
         void start_tag_bludgeoner();
         
@@ -49,6 +62,8 @@ namespace SixShooter {
         std::filesystem::path maps_directory;
         std::filesystem::path data_directory;
         std::vector<std::filesystem::path> tags_directories;
+        TagIndexService *tag_index;
+        std::unique_ptr<MapInfoCache> map_info_cache;
         
         QPushButton *invader_edit_qt_button;
         QPushButton *invader_edit_qt_unsafe_button;
@@ -15,6 +15,7 @@
 #include <QKeyEvent>
 
 #include "tag_tree_dialog.hpp"
+#include "tag_index_service.hpp"
 #include "console_box.hpp"
 #include "map_builder.hpp"
 #include "main_window.hpp"
@@ -180,12 +181,12 @@ namespace SixShooter {
     
     void MapBuilder::compile_map() {
         if(this->process != nullptr) {
-            delete this->process;
+            this->destroy_process(this->process);
             this->process = nullptr;
         }
         
         // Process
-        this->process = new QProcess(this);
+        this->process = this->create_process();
         this->process->setProgram(this->main_window->executable_path("invader-build").string().c_str());
         connect(this->process, &QProcess::stateChanged, this, &MapBuilder::set_ready);
         
@@ -302,7 +303,7 @@ namespace SixShooter {
         // Invoke
         this->process->setArguments(arguments);
         this->attach_to_process(this->process);
-        this->process->start();
+        this->start_process(this->process);
     }
     
     void MapBuilder::restore_settings() {
@@ -359,39 +360,23 @@ namespace SixShooter {
     }
     
     void MapBuilder::find_scenario_path() {
-        // Get all the tags
-        QStringList list;
-        
-        for(auto &i : this->main_window->get_tags_directories()) {
-            auto traverse_directory = [&list, &i](const std::filesystem::path &directory, auto &recursion) -> void {
-                try {
-                    for(auto &f : std::filesystem::directory_iterator(directory)) {
-                        if(std::filesystem::is_directory(f)) {
-                            recursion(f, recursion);
-                        }
-                        else if(std::filesystem::is_regular_file(f)) {
-                            auto relative_path = std::filesystem::relative(f, i);
-                            if(relative_path.extension() != ".scenario") {
-                                continue;
-                            }
-                            
-                            auto relative_path_str = QString(relative_path.string().c_str());
-                            if(!list.contains(relative_path_str)) {
-                                list << relative_path_str;
-                            }
-                        }
-                    }
-                }
-                catch (std::exception &e) {
-                    std::fprintf(stderr, "Failed to query %s: %s\n", directory.string().c_str(), e.what());
-                }
-            };
-            traverse_directory(i, traverse_directory);
-        }
-        
         TagTreeDialog dialog;
         dialog.setWindowTitle("Locate the scenario tag - Six Shooter");
-        dialog.set_data(list);
+
+        // The index is normally ready by now; if not, wait for it. Listen first so it can't get ready in between.
+        auto *index = this->main_window->get_tag_index();
+        auto connection = connect(index, &TagIndexService::updated, &dialog, [&dialog, index]() {
+            dialog.set_data(index->find_tags(".scenario"));
+        }, Qt::ConnectionType::SingleShotConnection);
+
+        if(index->is_ready()) {
+            disconnect(connection);
+            dialog.set_data(index->find_tags(".scenario"));
+        }
+        else {
+            dialog.set_pending("Searching for scenario tags...");
+        }
+
         if(dialog.exec()) {
             this->scenario_path->setText(std::filesystem::path(dialog.get_result().toStdString()).replace_extension("").string().c_str());
         }
@@ -415,7 +400,7 @@ namespace SixShooter {
     
     void MapBuilder::reject() {
         if(this->process) {
-            if(this->process->state() == QProcess::ProcessState::Running) {
+            if(this->process_is_running(this->process)) {
                 QMessageBox qmb;
                 qmb.setWindowTitle("Map compilation in progress");
                 qmb.setText("Are you sure you want to stop building the map?");
@@ -424,10 +409,9 @@ namespace SixShooter {
                 if(qmb.exec() == QMessageBox::StandardButton::Cancel) {
                     return;
                 }
-                this->process->kill();
-                this->process->waitForFinished(-1);
+                this->kill_process(this->process);
             }
-            delete this->process;
+            this->destroy_process(this->process);
             this->process = nullptr;
         }
         QDialog::reject();
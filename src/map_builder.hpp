@@ -16,6 +16,7 @@ class QLabel;
 
 namespace SixShooter {
     class MainWindow;
+    class ConsoleBox;
     
     class MapBuilder : public ConsoleDialog {
         Q_OBJECT
@@ -0,0 +1,553 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <QHBoxLayout>
+#include <QVBoxLayout>
+#include <QGridLayout>
+#include <QGroupBox>
+#include <QLabel>
+#include <QComboBox>
+#include <QCheckBox>
+#include <QSpinBox>
+#include <QProcess>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QHeaderView>
+#include <QMessageBox>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QScreen>
+#include <QGuiApplication>
+#include <QThread>
+#include <QTimer>
+#include <algorithm>
+
+#include "main_window.hpp"
+#include "map_extraction_queue.hpp"
+#include "settings.hpp"
+
+namespace SixShooter {
+    enum QueueColumn {
+        MapColumn,
+        StatusColumn,
+        SizeColumn,
+        TimeColumn
+    };
+
+    static const char *status_name(int status) {
+        static const char *names[] = { "Queued", "Extracting", "Done", "Failed", "Stopped" };
+        return names[status];
+    }
+
+    static QString format_time(qint64 ms) {
+        auto seconds = ms / 1000;
+        return QString("%1:%2").arg(seconds / 60).arg(seconds % 60, 2, 10, QChar('0'));
+    }
+
+    MapExtractionQueue::MapExtractionQueue(const MainWindow *main_window) : main_window(main_window) {
+        auto *main_layout = new QHBoxLayout(this);
+        this->setWindowTitle("Extract tags from several maps - Six Shooter");
+
+        auto *left_widget = new QWidget(this);
+        auto *left_layout = new QVBoxLayout(left_widget);
+        left_layout->setContentsMargins(0, 0, 0, 0);
+
+        // Options shared by every map
+        {
+            auto *options_widget = new QGroupBox("Parameters", left_widget);
+            auto *options_layout = new QGridLayout(options_widget);
+
+            this->tags = new QComboBox(options_widget);
+            for(auto &i : this->main_window->get_tags_directories()) {
+                this->tags->insertItem(0, i.string().c_str());
+            }
+            auto *tags_label = new QLabel("Tags directory:", options_widget);
+            tags_label->setSizePolicy(QSizePolicy::Policy::Fixed, QSizePolicy::Policy::Fixed);
+            options_layout->addWidget(tags_label, 0, 0);
+            options_layout->addWidget(this->tags, 0, 1);
+
+            this->non_mp_globals = new QCheckBox(options_widget);
+            auto *non_mp_globals_label = new QLabel("Extract non-multiplayer globals:", options_widget);
+            non_mp_globals_label->setSizePolicy(QSizePolicy::Policy::Fixed, QSizePolicy::Policy::Fixed);
+            options_layout->addWidget(non_mp_globals_label, 1, 0);
+            options_layout->addWidget(this->non_mp_globals, 1, 1);
+
+            this->overwrite = new QCheckBox(options_widget);
+            auto *overwrite_label = new QLabel("Overwrite:", options_widget);
+            overwrite_label->setSizePolicy(QSizePolicy::Policy::Fixed, QSizePolicy::Policy::Fixed);
+            options_layout->addWidget(overwrite_label, 2, 0);
+            options_layout->addWidget(this->overwrite, 2, 1);
+
+            this->ignore_resources = new QCheckBox(options_widget);
+            auto *ignore_external_label = new QLabel("Ignore external tags:", options_widget);
+            ignore_external_label->setSizePolicy(QSizePolicy::Policy::Fixed, QSizePolicy::Policy::Fixed);
+            options_layout->addWidget(ignore_external_label, 3, 0);
+            options_layout->addWidget(this->ignore_resources, 3, 1);
+
+            this->use_maps_preferences = new QCheckBox(options_widget);
+            auto *use_maps_preferences_label = new QLabel("Use maps folder from preferences:", options_widget);
+            use_maps_preferences_label->setSizePolicy(QSizePolicy::Policy::Fixed, QSizePolicy::Policy::Fixed);
+            options_layout->addWidget(use_maps_preferences_label, 4, 0);
+            options_layout->addWidget(this->use_maps_preferences, 4, 1);
+
+            // Can be changed while running; it takes effect as maps finish
+            this->concurrency = new QSpinBox(options_widget);
+            this->concurrency->setRange(1, std::max(1, QThread::idealThreadCount() * 2));
+            this->concurrency->setValue(SixShooterSettings().value("extraction_queue_concurrency", std::max(1, QThread::idealThreadCount() / 2)).toInt());
+            connect(this->concurrency, &QSpinBox::valueChanged, this, [this](int value) {
+                SixShooterSettings().setValue("extraction_queue_concurrency", value);
+                if(this->running) {
+                    this->start_jobs();
+                }
+            });
+            auto *concurrency_label = new QLabel("Maps at once:", options_widget);
+            concurrency_label->setSizePolicy(QSizePolicy::Policy::Fixed, QSizePolicy::Policy::Fixed);
+            options_layout->addWidget(concurrency_label, 5, 0);
+            options_layout->addWidget(this->concurrency, 5, 1);
+
+            options_widget->setLayout(options_layout);
+            options_widget->setSizePolicy(QSizePolicy::Policy::Expanding, QSizePolicy::Policy::Fixed);
+            left_layout->addWidget(options_widget);
+        }
+
+        // Maps
+        {
+            auto *queue_widget = new QGroupBox("Maps", left_widget);
+            auto *queue_layout = new QVBoxLayout(queue_widget);
+
+            this->queue = new QTreeWidget(queue_widget);
+            this->queue->setHeaderLabels(QStringList() << "Map" << "Status" << "Size" << "Time");
+            this->queue->setRootIsDecorated(false);
+            this->queue->setUniformRowHeights(true);
+            this->queue->setSelectionMode(QAbstractItemView::SelectionMode::ExtendedSelection);
+            this->queue->header()->setStretchLastSection(false);
+            this->queue->header()->setSectionResizeMode(MapColumn, QHeaderView::ResizeMode::Stretch);
+            connect(this->queue, &QTreeWidget::currentItemChanged, this, &MapExtractionQueue::show_job);
+            connect(this->queue, &QTreeWidget::itemSelectionChanged, this, &MapExtractionQueue::update_buttons);
+            queue_layout->addWidget(this->queue);
+
+            this->summary = new QLabel(queue_widget);
+            queue_layout->addWidget(this->summary);
+
+            auto *buttons = new QWidget(queue_widget);
+            auto *buttons_layout = new QHBoxLayout(buttons);
+            buttons_layout->setContentsMargins(0, 0, 0, 0);
+
+            this->add_button = new QPushButton("Add maps...", buttons);
+            connect(this->add_button, &QPushButton::clicked, this, &MapExtractionQueue::add_maps);
+            buttons_layout->addWidget(this->add_button);
+
+            this->remove_button = new QPushButton("Remove", buttons);
+            connect(this->remove_button, &QPushButton::clicked, this, &MapExtractionQueue::remove_maps);
+            buttons_layout->addWidget(this->remove_button);
+
+            this->start_button = new QPushButton("Start", buttons);
+            connect(this->start_button, &QPushButton::clicked, this, &MapExtractionQueue::start);
+            buttons_layout->addWidget(this->start_button);
+
+            this->stop_button = new QPushButton("Stop", buttons);
+            connect(this->stop_button, &QPushButton::clicked, this, &MapExtractionQueue::stop);
+            buttons_layout->addWidget(this->stop_button);
+
+            buttons->setLayout(buttons_layout);
+            queue_layout->addWidget(buttons);
+
+            queue_widget->setLayout(queue_layout);
+            left_layout->addWidget(queue_widget);
+        }
+
+        left_widget->setLayout(left_layout);
+        main_layout->addWidget(left_widget);
+
+        // Add a console on the right
+        main_layout->addWidget(this->get_console_widget());
+
+        // Keep the times and throughput ticking while running
+        this->refresh_timer = new QTimer(this);
+        this->refresh_timer->setInterval(1000);
+        connect(this->refresh_timer, &QTimer::timeout, this, [this]() {
+            for(auto &job : this->jobs) {
+                if(job->status == Status::Running) {
+                    this->update_job(*job);
+                }
+            }
+            this->update_summary();
+        });
+
+        auto screen_geometry = QGuiApplication::primaryScreen()->geometry();
+        this->setGeometry(
+            QStyle::alignedRect(
+                Qt::LeftToRight,
+                Qt::AlignCenter,
+                QSize(screen_geometry.width() / 5 * 4, screen_geometry.height() / 5 * 4),
+                screen_geometry
+            )
+        );
+
+        this->update_buttons();
+        this->update_summary();
+    }
+
+    MapExtractionQueue::~MapExtractionQueue() {
+        // Nothing can be added to the logs once these are gone
+        this->stop();
+
+        // Nor replayed once anything still waiting to be has had its turn
+        this->run_on_console_thread([]() {}, true);
+    }
+
+    QStringList MapExtractionQueue::extraction_arguments(const QString &map) const {
+        QStringList arguments;
+        arguments << "--tags" << this->tags->currentText();
+
+        if(this->use_maps_preferences->isChecked()) {
+            arguments << "--maps" << this->main_window->get_maps_directory().string().c_str();
+        }
+
+        arguments << map;
+
+        if(this->non_mp_globals->isChecked()) {
+            arguments << "--non-mp-globals";
+        }
+
+        if(this->overwrite->isChecked()) {
+            arguments << "--overwrite";
+        }
+
+        if(this->ignore_resources->isChecked()) {
+            arguments << "--ignore-resources";
+        }
+
+        return arguments;
+    }
+
+    void MapExtractionQueue::add_maps() {
+        QFileDialog qfd;
+        qfd.setFileMode(QFileDialog::FileMode::ExistingFiles);
+        qfd.setNameFilter("Maps (*.map)");
+        qfd.setWindowTitle("Please open the maps you want to extract");
+        qfd.setDirectory(std::filesystem::absolute(this->main_window->get_maps_directory()).string().c_str());
+
+        if(!qfd.exec()) {
+            return;
+        }
+
+        for(auto &path : qfd.selectedFiles()) {
+            // Already waiting to be extracted
+            if(std::any_of(this->jobs.begin(), this->jobs.end(), [&path](const std::unique_ptr<Job> &job) { return job->path == path && (job->status == Status::Queued || job->status == Status::Running); })) {
+                continue;
+            }
+
+            auto job = std::make_unique<Job>();
+            job->path = path;
+            job->log = std::make_shared<Log>();
+            job->size = QFileInfo(path).size();
+            job->item = new QTreeWidgetItem(this->queue);
+            job->item->setText(MapColumn, QFileInfo(path).fileName());
+            job->item->setToolTip(MapColumn, path);
+            job->item->setText(SizeColumn, QString("%1 MiB").arg(job->size / 1024.0 / 1024.0, 0, 'f', 1));
+            job->item->setTextAlignment(SizeColumn, Qt::AlignRight | Qt::AlignVCenter);
+            this->update_job(*job);
+            this->jobs.emplace_back(std::move(job));
+        }
+
+        if(this->running) {
+            this->start_jobs();
+        }
+        this->update_buttons();
+        this->update_summary();
+    }
+
+    void MapExtractionQueue::remove_maps() {
+        for(auto *item : this->queue->selectedItems()) {
+            auto *job = this->job_for(item);
+            if(job == nullptr || job->status == Status::Running) {
+                continue;
+            }
+
+            // Stop showing it if it's the one being shown
+            {
+                std::scoped_lock lock(this->console_mutex);
+                if(this->shown_log == job->log || this->replay_log == job->log) {
+                    this->shown_log = nullptr;
+                    this->replay_log = nullptr;
+                    this->reset_contents();
+                }
+            }
+
+            this->jobs.erase(std::find_if(this->jobs.begin(), this->jobs.end(), [job](const std::unique_ptr<Job> &i) { return i.get() == job; }));
+            delete item;
+        }
+
+        this->update_buttons();
+        this->update_summary();
+    }
+
+    void MapExtractionQueue::start() {
+        // Anything that didn't make it last time gets another go
+        for(auto &job : this->jobs) {
+            if(job->status == Status::Failed || job->status == Status::Stopped) {
+                job->status = Status::Queued;
+                this->update_job(*job);
+            }
+        }
+
+        this->running = true;
+        this->run_timer.start();
+        this->run_bytes = 0;
+        this->run_elapsed_ms = 0;
+        this->refresh_timer->start();
+        this->start_jobs();
+    }
+
+    void MapExtractionQueue::stop() {
+        if(this->running) {
+            this->run_elapsed_ms = this->run_timer.elapsed();
+        }
+        this->running = false;
+        this->refresh_timer->stop();
+
+        for(auto &job : this->jobs) {
+            if(job->status == Status::Running) {
+                this->kill_process(job->process);
+                this->destroy_process(job->process);
+                job->process = nullptr;
+                job->elapsed_ms = job->timer.elapsed();
+                job->status = Status::Stopped;
+                this->update_job(*job);
+            }
+        }
+
+        this->update_buttons();
+        this->update_summary();
+    }
+
+    void MapExtractionQueue::start_jobs() {
+        auto running_count = std::count_if(this->jobs.begin(), this->jobs.end(), [](const std::unique_ptr<Job> &job) { return job->status == Status::Running; });
+
+        // In the order they were added
+        for(auto &job : this->jobs) {
+            if(running_count >= this->concurrency->value()) {
+                break;
+            }
+            if(job->status == Status::Queued) {
+                this->start_job(*job);
+                running_count++;
+            }
+        }
+
+        // All done
+        if(running_count == 0 && this->running) {
+            this->run_elapsed_ms = this->run_timer.elapsed();
+            this->running = false;
+            this->refresh_timer->stop();
+        }
+
+        this->update_buttons();
+        this->update_summary();
+    }
+
+    void MapExtractionQueue::start_job(Job &job) {
+        job.status = Status::Running;
+        job.timer.start();
+        job.elapsed_ms = 0;
+
+        // A fresh log for each run, shown right away if this map is selected
+        auto log = std::make_shared<Log>();
+        {
+            std::scoped_lock lock(this->console_mutex);
+            if(this->shown_log == job.log || this->replay_log == job.log) {
+                this->reset_contents();
+                this->shown_log = log;
+                this->replay_log = nullptr;
+            }
+        }
+        job.log = log;
+
+        auto *process = this->create_process();
+        process->setProgram(this->main_window->executable_path("invader-extract").string().c_str());
+        process->setArguments(this->extraction_arguments(job.path));
+
+        auto env = process->processEnvironment();
+        env.insert("INVADER_FORCE_COLORS", "1");
+        process->setProcessEnvironment(env);
+
+        // Read on the console thread as it comes in
+        auto read = [this, process, log](bool standard_error) {
+            auto data = standard_error ? process->readAllStandardError() : process->readAllStandardOutput();
+
+            std::scoped_lock lock(this->console_mutex);
+            if(!log->chunks.empty() && log->chunks.back().first == standard_error && log->chunks.back().second.size() < LOG_CHUNK_SIZE) {
+                log->chunks.back().second.append(data);
+            }
+            else {
+                log->chunks.emplace_back(standard_error, data);
+            }
+
+            log->size += data.size();
+            while(log->size > MAX_LOG_SIZE && log->chunks.size() > 1) {
+                log->size -= log->chunks.front().second.size();
+                log->chunks.pop_front();
+                log->truncated = true;
+            }
+
+            if(this->shown_log == log) {
+                this->show_output(data, standard_error);
+            }
+        };
+        connect(process, &QProcess::readyReadStandardOutput, process, [read]() {
+            read(false);
+        }, Qt::ConnectionType::DirectConnection);
+        connect(process, &QProcess::readyReadStandardError, process, [read]() {
+            read(true);
+        }, Qt::ConnectionType::DirectConnection);
+
+        connect(process, &QProcess::finished, this, [this, process](int exit_code, QProcess::ExitStatus exit_status) {
+            this->finish_job(process, exit_code, exit_status);
+        });
+        connect(process, &QProcess::errorOccurred, this, [this, process](QProcess::ProcessError error) {
+            if(error == QProcess::ProcessError::FailedToStart) {
+                this->finish_job(process, -1, QProcess::ExitStatus::CrashExit);
+            }
+        });
+
+        job.process = process;
+        this->start_process(process);
+        this->update_job(job);
+    }
+
+    void MapExtractionQueue::finish_job(QProcess *process, int exit_code, QProcess::ExitStatus exit_status) {
+        // Stopped (or removed) since
+        auto job = std::find_if(this->jobs.begin(), this->jobs.end(), [process](const std::unique_ptr<Job> &job) { return job->process == process; });
+        if(job == this->jobs.end()) {
+            return;
+        }
+
+        auto &finished = **job;
+        finished.process = nullptr;
+        this->destroy_process(process);
+
+        finished.elapsed_ms = finished.timer.elapsed();
+        if(exit_status == QProcess::ExitStatus::NormalExit && exit_code == 0) {
+            finished.status = Status::Done;
+            this->run_bytes += finished.size;
+        }
+        else {
+            finished.status = Status::Failed;
+        }
+        this->update_job(finished);
+
+        if(this->running) {
+            this->start_jobs();
+        }
+    }
+
+    void MapExtractionQueue::show_job(QTreeWidgetItem *item) {
+        auto *job = this->job_for(item);
+        auto log = job != nullptr ? job->log : nullptr;
+
+        // Nothing new is shown until what was already printed is; that's replayed on the console thread, in order
+        // with anything still being read, so the GUI isn't held up
+        {
+            std::scoped_lock lock(this->console_mutex);
+            this->reset_contents();
+            this->shown_log = nullptr;
+            this->replay_log = log;
+        }
+        if(log == nullptr) {
+            return;
+        }
+
+        this->run_on_console_thread([this, log]() {
+            std::scoped_lock lock(this->console_mutex);
+
+            // Something else got selected in the meantime
+            if(this->replay_log != log) {
+                return;
+            }
+            this->replay_log = nullptr;
+            this->shown_log = log;
+
+            // Start on a whole line if the beginning was dropped
+            bool skip_partial_line = log->truncated;
+            if(skip_partial_line) {
+                this->show_output("(earlier output was not kept)\n");
+            }
+            for(auto &[standard_error, data] : log->chunks) {
+                if(skip_partial_line) {
+                    skip_partial_line = false;
+                    this->show_output(data.mid(data.indexOf('\n') + 1), standard_error);
+                }
+                else {
+                    this->show_output(data, standard_error);
+                }
+            }
+        });
+    }
+
+    void MapExtractionQueue::update_job(const Job &job) {
+        job.item->setText(StatusColumn, status_name(job.status));
+
+        qint64 elapsed = job.status == Status::Running ? job.timer.elapsed() : job.elapsed_ms;
+        job.item->setText(TimeColumn, job.status == Status::Queued ? QString() : format_time(elapsed));
+        job.item->setTextAlignment(TimeColumn, Qt::AlignRight | Qt::AlignVCenter);
+    }
+
+    void MapExtractionQueue::update_summary() {
+        int counts[Status::Stopped + 1] = {};
+        for(auto &job : this->jobs) {
+            counts[job->status]++;
+        }
+
+        auto text = QString("%1 of %2 maps done").arg(counts[Status::Done]).arg(this->jobs.size());
+        if(counts[Status::Running] > 0) {
+            text += QString(", %1 extracting").arg(counts[Status::Running]);
+        }
+        if(counts[Status::Failed] > 0) {
+            text += QString(", %1 failed").arg(counts[Status::Failed]);
+        }
+
+        // Counts maps as they finish, so it's rough until a few are done
+        if(this->run_bytes > 0) {
+            auto seconds = std::max<qint64>(this->running ? this->run_timer.elapsed() : this->run_elapsed_ms, 1) / 1000.0;
+            text += QString(" (%1 MiB/s)").arg(this->run_bytes / 1024.0 / 1024.0 / seconds, 0, 'f', 1);
+        }
+
+        this->summary->setText(text);
+    }
+
+    void MapExtractionQueue::update_buttons() {
+        bool can_start = std::any_of(this->jobs.begin(), this->jobs.end(), [](const std::unique_ptr<Job> &job) { return job->status != Status::Done; });
+        this->start_button->setEnabled(!this->running && can_start);
+        this->stop_button->setEnabled(this->running);
+        this->remove_button->setEnabled(!this->queue->selectedItems().isEmpty());
+
+        // Every map gets the same options
+        for(QWidget *option : { static_cast<QWidget *>(this->tags), static_cast<QWidget *>(this->non_mp_globals), static_cast<QWidget *>(this->overwrite), static_cast<QWidget *>(this->ignore_resources), static_cast<QWidget *>(this->use_maps_preferences) }) {
+            option->setEnabled(!this->running);
+        }
+    }
+
+    MapExtractionQueue::Job *MapExtractionQueue::job_for(QTreeWidgetItem *item) {
+        for(auto &job : this->jobs) {
+            if(job->item == item) {
+                return job.get();
+            }
+        }
+        return nullptr;
+    }
+
+    void MapExtractionQueue::reject() {
+        if(this->running) {
+            QMessageBox qmb;
+            qmb.setWindowTitle("Tag extraction in progress");
+            qmb.setText("Are you sure you want to stop extracting tags?\n\nAborting the extraction process may leave your tags directory in an inconsistent or potentially corrupted state.");
+            qmb.setIcon(QMessageBox::Icon::Warning);
+            qmb.setStandardButtons(QMessageBox::StandardButton::Abort | QMessageBox::StandardButton::Cancel);
+            if(qmb.exec() == QMessageBox::StandardButton::Cancel) {
+                return;
+            }
+        }
+        this->stop();
+        QDialog::reject();
+    }
+}
@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SIX_SHOOTER_MAP_EXTRACTION_QUEUE_HPP
+#define SIX_SHOOTER_MAP_EXTRACTION_QUEUE_HPP
+
+#include <QDialog>
+#include <QElapsedTimer>
+#include <QProcess>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "console_dialog.hpp"
+
+class QComboBox;
+class QCheckBox;
+class QLabel;
+class QPushButton;
+class QSpinBox;
+class QTimer;
+class QTreeWidget;
+class QTreeWidgetItem;
+
+namespace SixShooter {
+    class MainWindow;
+
+    // Extracts every tag from several maps, a few at a time, all with the same options. The console shows whichever
+    // map is selected.
+    class MapExtractionQueue : public ConsoleDialog {
+        Q_OBJECT
+        friend class MainWindow;
+
+    private:
+        enum Status {
+            Queued,
+            Running,
+            Done,
+            Failed,
+            Stopped
+        };
+
+        // What a map's extraction printed, so it can be shown again. Filled in on the console thread. Only about the last
+        // MAX_LOG_SIZE bytes are kept, in pieces of about LOG_CHUNK_SIZE so the oldest can be dropped as it goes.
+        static constexpr qsizetype MAX_LOG_SIZE = 2 * 1024 * 1024;
+        static constexpr qsizetype LOG_CHUNK_SIZE = 64 * 1024;
+        struct Log {
+            std::deque<std::pair<bool, QByteArray>> chunks;
+            qsizetype size = 0;
+            bool truncated = false;
+        };
+
+        struct Job {
+            QString path;
+            qint64 size;
+            Status status = Status::Queued;
+            QElapsedTimer timer;
+            qint64 elapsed_ms = 0;
+            QProcess *process = nullptr;
+            QTreeWidgetItem *item;
+            std::shared_ptr<Log> log;
+        };
+
+        MapExtractionQueue(const MainWindow *main_window);
+        ~MapExtractionQueue() override;
+        const MainWindow *main_window;
+
+        QComboBox *tags;
+        QCheckBox *non_mp_globals;
+        QCheckBox *overwrite;
+        QCheckBox *ignore_resources;
+        QCheckBox *use_maps_preferences;
+        QSpinBox *concurrency;
+        QTreeWidget *queue;
+        QLabel *summary;
+        QPushButton *start_button;
+        QPushButton *stop_button;
+        QPushButton *add_button;
+        QPushButton *remove_button;
+        QTimer *refresh_timer;
+
+        std::vector<std::unique_ptr<Job>> jobs;
+        bool running = false;
+
+        // Throughput is how many bytes of maps got extracted since starting
+        QElapsedTimer run_timer;
+        qint64 run_elapsed_ms = 0;
+        qint64 run_bytes = 0;
+
+        // Whose output goes to the console; also held while adding to any log so nothing is shown twice or out of order
+        std::mutex console_mutex;
+        std::shared_ptr<Log> shown_log;
+
+        // Selected, but still waiting for what it already printed to be shown again on the console thread
+        std::shared_ptr<Log> replay_log;
+
+        void add_maps();
+        void remove_maps();
+        void start();
+        void stop();
+        void start_jobs();
+        void start_job(Job &job);
+        void finish_job(QProcess *process, int exit_code, QProcess::ExitStatus exit_status);
+        void show_job(QTreeWidgetItem *item);
+        void update_job(const Job &job);
+        void update_summary();
+        void update_buttons();
+        Job *job_for(QTreeWidgetItem *item);
+        QStringList extraction_arguments(const QString &map) const;
+
+        void reject() override;
+    };
+}
+
+#endif
@@ -17,10 +17,17 @@
 #include <QScreen>
 #include <QFileDialog>
 #include <QGuiApplication>
+#include <QTimer>
+#include <QThread>
+#include <QHash>
+#include <QSet>
+#include <algorithm>
+#include <memory>
 
 #include "console_box.hpp"
 #include "main_window.hpp"
 #include "map_extractor.hpp"
+#include "map_reader.hpp"
 #include "tag_tree_widget.hpp"
 
 namespace SixShooter {
@@ -72,9 +79,15 @@ namespace SixShooter {
             options_layout->addWidget(use_maps_preferences_label, 4, 0);
             options_layout->addWidget(this->use_maps_preferences, 4, 1);
 
+            this->parallel = new QCheckBox(options_widget);
+            auto *parallel_label = new QLabel("Extract all tags in parallel:", options_widget);
+            parallel_label->setSizePolicy(QSizePolicy::Policy::Fixed, QSizePolicy::Policy::Fixed);
+            options_layout->addWidget(parallel_label, 5, 0);
+            options_layout->addWidget(this->parallel, 5, 1);
+
             auto *generate_index_button = new QPushButton("Generate index file", options_widget);
             connect(generate_index_button, &QPushButton::clicked, this, &MapExtractor::generate_index_file);
-            options_layout->addWidget(generate_index_button, 5, 1);
+            options_layout->addWidget(generate_index_button, 6, 1);
 
             // Set the layout
             options_widget->setLayout(options_layout);
@@ -89,13 +102,34 @@ namespace SixShooter {
             auto *tags_layout = new QVBoxLayout(tags_widget);
 
             this->map_tags = new TagTreeWidget(tags_widget);
-            connect(this->map_tags, &TagTreeWidget::itemDoubleClicked, this, &MapExtractor::double_clicked);
+            this->map_tags->setSelectionMode(QAbstractItemView::SelectionMode::ExtendedSelection);
+            connect(this->map_tags, &TagTreeWidget::doubleClicked, this, &MapExtractor::double_clicked);
+            connect(this->map_tags->selectionModel(), &QItemSelectionModel::selectionChanged, this, &MapExtractor::update_extract_selected_button);
+
+            auto *tags_filter = new QLineEdit(tags_widget);
+            tags_filter->setPlaceholderText("Filter (e.g. warthog, .bitmap, weapons\\*\\*.weapon)");
+            tags_filter->setClearButtonEnabled(true);
+            connect(tags_filter, &QLineEdit::textChanged, this->map_tags, &TagTreeWidget::set_filter);
+            tags_layout->addWidget(tags_filter);
+
             tags_layout->addWidget(this->map_tags);
 
-            // Extract button
-            this->extract_button = new QPushButton("Extract all tags", tags_widget);
+            // Extract buttons
+            auto *extract_buttons = new QWidget(tags_widget);
+            auto *extract_buttons_layout = new QHBoxLayout(extract_buttons);
+            extract_buttons_layout->setContentsMargins(0, 0, 0, 0);
+
+            this->extract_selected_button = new QPushButton("Extract selected tags", extract_buttons);
+            this->extract_selected_button->setEnabled(false);
+            connect(this->extract_selected_button, &QPushButton::clicked, this, &MapExtractor::extract_selected);
+            extract_buttons_layout->addWidget(this->extract_selected_button);
+
+            this->extract_button = new QPushButton("Extract all tags", extract_buttons);
             connect(this->extract_button, &QPushButton::clicked, this, &MapExtractor::extract_full_map);
-            tags_layout->addWidget(this->extract_button);
+            extract_buttons_layout->addWidget(this->extract_button);
+
+            extract_buttons->setLayout(extract_buttons_layout);
+            tags_layout->addWidget(extract_buttons);
 
             tags_widget->setLayout(tags_layout);
             left_layout->addWidget(tags_widget);
@@ -118,27 +152,58 @@ namespace SixShooter {
             )
         );
 
+        this->map_tags_timer = new QTimer(this);
+        this->map_tags_timer->setSingleShot(true);
+        this->map_tags_timer->setInterval(TAG_UPDATE_INTERVAL_MS);
+        connect(this->map_tags_timer, &QTimer::timeout, this, [this]() {
+            this->map_tags->update_data(this->map_tag_list);
+        });
+
         this->reload_info();
     }
 
+    MapExtractor::~MapExtractor() {
+        // Nothing can be handed back to us once these are gone
+        this->stop_info();
+    }
+
     void MapExtractor::set_ready(QProcess::ProcessState state) {
-        this->extract_button->setEnabled(state == QProcess::ProcessState::NotRunning);
-        this->map_tags->setEnabled(state == QProcess::ProcessState::NotRunning);
+        this->extracting = state != QProcess::ProcessState::NotRunning;
+        this->extract_button->setEnabled(!this->extracting);
+        this->map_tags->setEnabled(!this->extracting);
+        this->update_extract_selected_button();
     }
 
-    void MapExtractor::extract_map(const std::vector<std::string> &filter, bool recursive, bool overwrite_anyway) {
-        if(this->process != nullptr) {
-            this->process->kill();
-            delete this->process;
-            this->process = nullptr;
+    void MapExtractor::update_extract_selected_button() {
+        this->extract_selected_button->setEnabled(!this->extracting && this->map_tags->selectionModel()->hasSelection());
+    }
+
+    static qsizetype command_line_length(const QStringList &arguments) {
+        // Leave room for quotes and spaces
+        qsizetype length = 0;
+        for(auto &i : arguments) {
+            length += i.size() + 3;
         }
+        return length;
+    }
 
-        // Process
-        this->process = new QProcess(this);
-        connect(this->process, &QProcess::stateChanged, this, &MapExtractor::set_ready);
-        this->process->setProgram(this->main_window->executable_path("invader-extract").string().c_str());
+    // Split searches up so that adding each part to a command line that's base_length long stays under the limit
+    static std::vector<QStringList> chunk_searches(const QStringList &searches, qsizetype base_length, qsizetype max_length) {
+        std::vector<QStringList> chunks;
+        auto length = base_length;
+        for(auto &i : searches) {
+            auto search_length = command_line_length({ "--search", i });
+            if(chunks.empty() || (length + search_length > max_length && !chunks.back().isEmpty())) {
+                chunks.emplace_back();
+                length = base_length;
+            }
+            chunks.back() << i;
+            length += search_length;
+        }
+        return chunks;
+    }
 
-        // Set arguments
+    QStringList MapExtractor::extraction_arguments(bool recursive, bool overwrite_anyway) const {
         QStringList arguments;
         arguments << "--tags" << this->tags->currentText();
 
@@ -164,73 +229,434 @@ namespace SixShooter {
             arguments << "--ignore-resources";
         }
 
+        return arguments;
+    }
+
+    void MapExtractor::extract_map(const QStringList &filter, bool recursive, bool overwrite_anyway) {
+        this->stop_extraction();
+
+        auto program = QString(this->main_window->executable_path("invader-extract").string().c_str());
+        auto arguments = this->extraction_arguments(recursive, overwrite_anyway);
+
+        // Too many searches for one command line; run them one after another
+        auto chunks = chunk_searches(filter, command_line_length(QStringList(program) << arguments), MAX_COMMAND_LINE_LENGTH);
+        if(chunks.size() > 1) {
+            return this->run_shards(std::move(chunks), 1, std::move(arguments));
+        }
+
+        // Process
+        this->process = this->create_process();
+        connect(this->process, &QProcess::stateChanged, this, &MapExtractor::set_ready);
+        this->process->setProgram(program);
+
+        // Set arguments
         for(auto &i : filter) {
-            arguments << "--search" << i.c_str();
+            arguments << "--search" << i;
         }
 
         // Invoke
         this->process->setArguments(arguments);
         this->attach_to_process(this->process);
         this->reset_contents();
-        this->process->start();
+        this->start_process(this->process);
     }
 
     void MapExtractor::extract_full_map() {
+        // Needs the whole tag list to split it up, and there's no point for tiny maps
+        if(this->parallel->isChecked() && this->map_tags_read && this->map_tag_list.size() >= MIN_TAGS_PER_SHARD * 2) {
+            return extract_map_sharded();
+        }
         return extract_map();
     }
 
-    QString MapExtractor::get_map_info(const char *what) const {
-        // Process
-        QProcess process;
-        process.setProgram(this->main_window->executable_path("invader-info").string().c_str());
+    struct ShardGroup {
+        QStringList searches;
+        qsizetype tag_count;
+    };
+
+    // Split a sorted range of tags that all start with the first prefix_length characters into groups of no more than
+    // max_size tags (where a directory can be split that far), each found with as few searches as possible.
+    static void group_tags(const QStringList &tags, qsizetype begin, qsizetype end, qsizetype prefix_length, qsizetype max_size, std::vector<ShardGroup> &groups) {
+        auto prefix = tags[begin].left(prefix_length);
+        if(end - begin <= max_size) {
+            groups.emplace_back(ShardGroup { QStringList(prefix + "*"), end - begin });
+            return;
+        }
 
-        QStringList arguments;
-        arguments << "--type" << what;
-        arguments << this->path.string().c_str();
-        process.setArguments(arguments);
+        // Split it up by subdirectory, and keep tags right in this directory for last
+        QHash<QString, QStringList> files_by_class;
+        QSet<QString> subdirectory_classes;
+        auto class_of = [](const QString &tag) {
+            auto dot = tag.lastIndexOf('.');
+            return dot < 0 || dot < tag.lastIndexOf('\\') ? QString() : tag.mid(dot + 1);
+        };
+
+        for(qsizetype i = begin; i < end;) {
+            auto separator = tags[i].indexOf('\\', prefix_length);
+            if(separator < 0) {
+                files_by_class[class_of(tags[i])] << tags[i];
+                i++;
+                continue;
+            }
+
+            auto subdirectory = QStringView(tags[i]).left(separator + 1);
+            auto j = i + 1;
+            while(j < end && tags[j].startsWith(subdirectory)) {
+                j++;
+            }
+
+            for(auto k = i; k < j; k++) {
+                subdirectory_classes.insert(class_of(tags[k]));
+            }
+            group_tags(tags, i, j, separator + 1, max_size, groups);
+            i = j;
+        }
+
+        // "prefix\*.class" would also find that class in subdirectories, so only use it if there aren't any there.
+        // Sorted by class so the same map always gets split the same way.
+        auto classes = files_by_class.keys();
+        classes.sort();
+        for(auto &tag_class : classes) {
+            auto &files = files_by_class[tag_class];
+            if(!tag_class.isEmpty() && !subdirectory_classes.contains(tag_class)) {
+                groups.emplace_back(ShardGroup { QStringList(prefix + "*." + tag_class), files.size() });
+            }
+            else {
+                groups.emplace_back(ShardGroup { files, files.size() });
+            }
+        }
+    }
+
+    // Split the map's tags into shards of about the same size. Every tag is in exactly one shard.
+    static std::vector<QStringList> shard_tags(const QStringList &map_tags, std::size_t shard_count) {
+        // Unidentified (".none") tags and blank lines are left out of the tree and can't be searched for either
+        QStringList tags;
+        tags.reserve(map_tags.size());
+        for(auto &i : map_tags) {
+            if(i.trimmed().endsWith(".none") || i.trimmed().isEmpty()) {
+                continue;
+            }
+            tags << QString(i).replace('/', '\\');
+        }
+        tags.sort();
+        tags.removeDuplicates();
+        if(tags.isEmpty()) {
+            return {};
+        }
+
+        std::vector<ShardGroup> groups;
+        auto max_group_size = std::max<qsizetype>(1, tags.size() / static_cast<qsizetype>(shard_count * 2));
+        group_tags(tags, 0, tags.size(), 0, max_group_size, groups);
+
+        // Biggest groups first, each into whichever shard is the smallest so far
+        std::stable_sort(groups.begin(), groups.end(), [](const ShardGroup &a, const ShardGroup &b) {
+            return a.tag_count > b.tag_count;
+        });
+
+        std::vector<QStringList> shards(shard_count);
+        std::vector<qsizetype> sizes(shard_count, 0);
+        for(auto &group : groups) {
+            auto smallest = std::min_element(sizes.begin(), sizes.end()) - sizes.begin();
+            shards[smallest] << group.searches;
+            sizes[smallest] += group.tag_count;
+        }
+
+        shards.erase(std::remove_if(shards.begin(), shards.end(), [](const QStringList &shard) { return shard.isEmpty(); }), shards.end());
+        return shards;
+    }
+
+    void MapExtractor::extract_map_sharded() {
+        // Every tag is extracted by exactly one process and nothing is extracted recursively, so no two processes ever
+        // write the same tag, and the result is the same as extracting everything with one
+        auto process_count = static_cast<std::size_t>(std::max(1, QThread::idealThreadCount()));
+        auto shard_count = std::min(process_count * SHARDS_PER_PROCESS, static_cast<std::size_t>(this->map_tag_list.size() / MIN_TAGS_PER_SHARD));
+
+        auto program = QString(this->main_window->executable_path("invader-extract").string().c_str());
+        auto arguments = this->extraction_arguments(false, false);
+        auto base_length = command_line_length(QStringList(program) << arguments);
+
+        std::vector<QStringList> shards;
+        for(auto &shard : shard_tags(this->map_tag_list, shard_count)) {
+            for(auto &chunk : chunk_searches(shard, base_length, MAX_COMMAND_LINE_LENGTH)) {
+                shards.emplace_back(std::move(chunk));
+            }
+        }
+
+        // Nothing in the list that can be searched for, so let invader-extract find everything itself
+        if(shards.empty()) {
+            return this->extract_map();
+        }
+
+        this->run_shards(std::move(shards), process_count, std::move(arguments));
+    }
+
+    void MapExtractor::run_shards(std::vector<QStringList> shards, std::size_t process_count, QStringList arguments) {
+        this->stop_extraction();
+        this->pending_shards.assign(std::make_move_iterator(shards.begin()), std::make_move_iterator(shards.end()));
+        this->shard_arguments = std::move(arguments);
+
+        this->reset_contents();
+        this->set_ready(QProcess::ProcessState::Running);
+
+        // Start as many as can run at once; the rest start as those finish
+        for(std::size_t i = 0; i < process_count && !this->pending_shards.empty(); i++) {
+            this->start_next_shard();
+        }
+    }
+
+    void MapExtractor::start_next_shard() {
+        auto searches = std::move(this->pending_shards.front());
+        this->pending_shards.pop_front();
 
-        process.start();
-        process.waitForFinished(-1);
+        auto *process = this->create_process();
+        process->setProgram(this->main_window->executable_path("invader-extract").string().c_str());
 
-        return QString(process.readAllStandardOutput()).replace("\r", "").trimmed();
+        auto arguments = this->shard_arguments;
+        for(auto &i : searches) {
+            arguments << "--search" << i;
+        }
+        process->setArguments(arguments);
+
+        this->attach_to_process(process, nullptr, true);
+        connect(process, &QProcess::finished, this, [this, process]() {
+            this->finish_shard(process);
+        });
+        connect(process, &QProcess::errorOccurred, this, [this, process](QProcess::ProcessError error) {
+            if(error == QProcess::ProcessError::FailedToStart) {
+                this->finish_shard(process);
+            }
+        });
+
+        this->shard_processes.emplace_back(process);
+        this->start_process(process);
+    }
+
+    void MapExtractor::finish_shard(QProcess *process) {
+        // Already stopped
+        auto shard = std::find(this->shard_processes.begin(), this->shard_processes.end(), process);
+        if(shard == this->shard_processes.end()) {
+            return;
+        }
+        this->shard_processes.erase(shard);
+        this->destroy_process(process);
+
+        if(!this->pending_shards.empty()) {
+            this->start_next_shard();
+        }
+        else if(this->shard_processes.empty()) {
+            this->set_ready(QProcess::ProcessState::NotRunning);
+        }
+    }
+
+    bool MapExtractor::extraction_running() {
+        return (this->process != nullptr && this->process_is_running(this->process)) || !this->shard_processes.empty();
+    }
+
+    void MapExtractor::stop_extraction() {
+        if(this->process != nullptr) {
+            this->kill_process(this->process);
+            this->destroy_process(this->process);
+            this->process = nullptr;
+        }
+
+        this->pending_shards.clear();
+        for(auto *shard : this->shard_processes) {
+            this->kill_process(shard);
+            this->destroy_process(shard);
+        }
+        this->shard_processes.clear();
     }
 
     void MapExtractor::reload_info() {
-        QProcess process;
-        process.setProgram(this->main_window->executable_path("invader-info").string().c_str());
-        this->attach_to_process(&process);
-        process.setArguments(QStringList(this->path.string().c_str()));
-        process.start();
-        process.waitForFinished(-1);
-
-        auto tags = get_map_info("tags").split("\n");
-        this->map_tags->set_data(tags);
+        this->stop_info();
+        this->map_tag_list.clear();
+        this->map_summary.reset();
+        this->map_tags_read = false;
+
+        // Opened before and unchanged since, so there's nothing to ask invader-info
+        auto *cache = this->main_window->get_map_info_cache();
+        this->cache_key = MapInfoCache::make_key(this->path);
+        if(this->cache_key.has_value()) {
+            auto cached = cache->find(*this->cache_key);
+            if(cached.has_value() && cached->has_contents) {
+                this->show_output(cached->summary);
+                this->map_tag_list = cached->tags;
+                this->map_tags_read = true;
+                this->map_tags->set_data(cached->tags);
+                return;
+            }
+        }
+
+        // Most maps can be read directly, leaving invader-info with just the summary
+        MapReader reader(this->path);
+        if(reader.is_open()) {
+            this->map_tag_list = reader.get_tags();
+            this->map_tags_read = true;
+            this->map_tags->set_data(this->map_tag_list);
+        }
+        else {
+            this->map_tags->set_pending("Reading map...");
+        }
+
+        auto invader_info = QString(this->main_window->executable_path("invader-info").string().c_str());
+        auto map_path = QString(this->path.string().c_str());
+
+        // These run at the same time on the console thread. The summary goes to the console (and a copy is kept for the
+        // cache)...
+        this->info_process = this->create_process();
+        this->info_process->setProgram(invader_info);
+        this->info_process->setArguments(QStringList(map_path));
+        auto summary = std::make_shared<QByteArray>();
+        this->attach_to_process(this->info_process, summary);
+
+        connect(this->info_process, &QProcess::finished, this->info_process, [this, summary](int exit_code, QProcess::ExitStatus exit_status) {
+            auto succeeded = exit_status == QProcess::ExitStatus::NormalExit && exit_code == 0;
+            QMetaObject::invokeMethod(this, [this, summary = *summary, succeeded]() {
+                this->set_map_summary(summary, succeeded);
+            }, Qt::ConnectionType::QueuedConnection);
+        }, Qt::ConnectionType::DirectConnection);
+
+        this->start_process(this->info_process);
+        if(this->map_tags_read) {
+            return;
+        }
+
+        // ...and the tag list, unless it was already read, is split into lines as it comes in and handed over to the tree
+        this->tags_process = this->create_process();
+        this->tags_process->setProgram(invader_info);
+        this->tags_process->setArguments(QStringList() << "--type" << "tags" << map_path);
+
+        auto *tags_process = this->tags_process;
+        auto partial = std::make_shared<QByteArray>();
+        auto read_lines = [tags_process, partial](bool finished) {
+            partial->append(tags_process->readAllStandardOutput());
+            auto end = finished ? partial->size() : partial->lastIndexOf('\n') + 1;
+            auto lines = QString::fromUtf8(partial->constData(), end).remove('\r').split('\n', Qt::SkipEmptyParts);
+            partial->remove(0, end);
+            return lines;
+        };
+
+        connect(tags_process, &QProcess::readyReadStandardOutput, tags_process, [this, read_lines]() {
+            auto lines = read_lines(false);
+            if(!lines.isEmpty()) {
+                QMetaObject::invokeMethod(this, [this, lines]() {
+                    this->add_map_tags(lines, false, true);
+                }, Qt::ConnectionType::QueuedConnection);
+            }
+        }, Qt::ConnectionType::DirectConnection);
+
+        connect(tags_process, &QProcess::finished, tags_process, [this, read_lines](int exit_code, QProcess::ExitStatus exit_status) {
+            auto lines = read_lines(true);
+            auto succeeded = exit_status == QProcess::ExitStatus::NormalExit && exit_code == 0;
+            QMetaObject::invokeMethod(this, [this, lines, succeeded]() {
+                this->add_map_tags(lines, true, succeeded);
+            }, Qt::ConnectionType::QueuedConnection);
+        }, Qt::ConnectionType::DirectConnection);
+
+        // Failing to start doesn't emit finished
+        connect(tags_process, &QProcess::errorOccurred, tags_process, [this](QProcess::ProcessError error) {
+            if(error == QProcess::ProcessError::FailedToStart) {
+                QMetaObject::invokeMethod(this, [this]() {
+                    this->add_map_tags(QStringList(), true, false);
+                }, Qt::ConnectionType::QueuedConnection);
+            }
+        }, Qt::ConnectionType::DirectConnection);
+
+        this->start_process(this->tags_process);
     }
 
-    void MapExtractor::double_clicked(QTreeWidgetItem *item, int column) {
-        auto data = item->data(column, Qt::UserRole);
-        if(!data.isNull()) {
-            QMessageBox options;
-            options.setWindowTitle("Extraction options");
-            options.setIcon(QMessageBox::Icon::Question);
-            options.setText(QString("You are about to extract ") + data.toString());
-            options.setStandardButtons(QMessageBox::StandardButton::Cancel);
-            options.addButton("Extract (single tag)", QMessageBox::ButtonRole::AcceptRole);
-            options.addButton("Extract (recursive)", QMessageBox::ButtonRole::AcceptRole);
+    void MapExtractor::stop_info() {
+        for(auto **process : { &this->info_process, &this->tags_process }) {
+            if(*process != nullptr) {
+                this->kill_process(*process);
+                this->destroy_process(*process);
+                *process = nullptr;
+            }
+        }
+        this->map_tags_timer->stop();
+    }
+
+    void MapExtractor::set_map_summary(const QByteArray &summary, bool succeeded) {
+        if(!succeeded) {
+            this->cache_key.reset();
+            return;
+        }
+        this->map_summary = summary;
+        this->cache_info();
+    }
 
-            auto *overwrite = new QCheckBox("Overwrite tag(s) on disk (if present)", &options);
-            options.setCheckBox(overwrite);
+    void MapExtractor::add_map_tags(const QStringList &tags, bool finished, bool succeeded) {
+        this->map_tag_list << tags;
 
-            int r = options.exec();
+        if(finished) {
+            this->map_tags_timer->stop();
+            this->map_tags->update_data(this->map_tag_list);
 
-            if(options.result() == QMessageBox::StandardButton::Cancel) {
+            if(!succeeded) {
+                this->cache_key.reset();
                 return;
             }
+            this->map_tags_read = true;
+            this->cache_info();
+        }
+        else if(!this->map_tags_timer->isActive()) {
+            this->map_tags_timer->start();
+        }
+    }
+
+    void MapExtractor::cache_info() {
+        // Only once both came back fine
+        if(this->cache_key.has_value() && this->map_summary.has_value() && this->map_tags_read) {
+            this->main_window->get_map_info_cache()->set_contents(*this->cache_key, *this->map_summary, this->map_tag_list);
+        }
+    }
+
+    void MapExtractor::double_clicked(const QModelIndex &index) {
+        auto data = index.data(Qt::UserRole);
+        if(!data.isNull()) {
+            this->extract_tags(QStringList(data.toString()), data.toString());
+        }
+    }
+
+    void MapExtractor::extract_selected() {
+        auto searches = this->map_tags->get_selected_searches();
+        if(searches.isEmpty()) {
+            return;
+        }
+
+        auto folders = std::count_if(searches.begin(), searches.end(), [](const QString &search) { return search.endsWith('*'); });
+        auto tags = searches.size() - folders;
+        QStringList description;
+        if(tags > 0) {
+            description << QString("%1 tag%2").arg(tags).arg(tags == 1 ? "" : "s");
+        }
+        if(folders > 0) {
+            description << QString("%1 folder%2").arg(folders).arg(folders == 1 ? "" : "s");
+        }
 
-            std::vector<std::string> filters;
-            filters.emplace_back(data.toString().toStdString());
-            this->extract_map(filters, r == 1, overwrite->isChecked());
+        this->extract_tags(searches, description.join(" and "));
+    }
+
+    void MapExtractor::extract_tags(const QStringList &searches, const QString &description) {
+        QMessageBox options;
+        options.setWindowTitle("Extraction options");
+        options.setIcon(QMessageBox::Icon::Question);
+        options.setText(QString("You are about to extract ") + description);
+        options.setStandardButtons(QMessageBox::StandardButton::Cancel);
+        options.addButton("Extract (single tag)", QMessageBox::ButtonRole::AcceptRole);
+        options.addButton("Extract (recursive)", QMessageBox::ButtonRole::AcceptRole);
+
+        auto *overwrite = new QCheckBox("Overwrite tag(s) on disk (if present)", &options);
+        options.setCheckBox(overwrite);
+
+        int r = options.exec();
+
+        if(options.result() == QMessageBox::StandardButton::Cancel) {
+            return;
         }
+
+        // Everything at once
+        this->extract_map(searches, r == 1, overwrite->isChecked());
     }
 
     void MapExtractor::generate_index_file() {
@@ -245,9 +671,9 @@ namespace SixShooter {
 
             // Wait until the process finished
             if(this->process) {
-                this->process->waitForFinished(-1);
+                this->wait_for_process(this->process);
+                this->destroy_process(this->process);
                 this->process = nullptr;
-                delete this->process;
             }
 
             // Spawn a new one
@@ -263,22 +689,17 @@ namespace SixShooter {
     }
 
     void MapExtractor::reject() {
-        if(this->process) {
-            if(this->process->state() == QProcess::ProcessState::Running) {
-                QMessageBox qmb;
-                qmb.setWindowTitle("Tag extraction in progress");
-                qmb.setText("Are you sure you want to stop extracting tags?\n\nAborting the extraction process may leave your tags directory in an inconsistent or potentially corrupted state.");
-                qmb.setIcon(QMessageBox::Icon::Warning);
-                qmb.setStandardButtons(QMessageBox::StandardButton::Abort | QMessageBox::StandardButton::Cancel);
-                if(qmb.exec() == QMessageBox::StandardButton::Cancel) {
-                    return;
-                }
-                this->process->kill();
-                this->process->waitForFinished(-1);
+        if(this->extraction_running()) {
+            QMessageBox qmb;
+            qmb.setWindowTitle("Tag extraction in progress");
+            qmb.setText("Are you sure you want to stop extracting tags?\n\nAborting the extraction process may leave your tags directory in an inconsistent or potentially corrupted state.");
+            qmb.setIcon(QMessageBox::Icon::Warning);
+            qmb.setStandardButtons(QMessageBox::StandardButton::Abort | QMessageBox::StandardButton::Cancel);
+            if(qmb.exec() == QMessageBox::StandardButton::Cancel) {
+                return;
             }
-            delete this->process;
-            this->process = nullptr;
         }
+        this->stop_extraction();
         QDialog::reject();
     }
 }
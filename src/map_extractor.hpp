@@ -5,18 +5,21 @@
 
 #include <QDialog>
 #include <QProcess>
-#include <string>
+#include <deque>
 #include <vector>
 #include <filesystem>
+#include <optional>
 
 #include "console_dialog.hpp"
+#include "map_info_cache.hpp"
 
 class QLineEdit;
 class QComboBox;
 class QCheckBox;
 class QTreeWidget;
 class QPushButton;
-class QTreeWidgetItem;
+class QModelIndex;
+class QTimer;
 
 namespace SixShooter {
     class MainWindow;
@@ -27,6 +30,7 @@ namespace SixShooter {
         friend class MainWindow;
     private:
         MapExtractor(const MainWindow *main_window, const std::filesystem::path &path);
+        ~MapExtractor() override;
         const MainWindow *main_window;
         
         const std::filesystem::path &path;
@@ -35,24 +39,66 @@ namespace SixShooter {
         QProcess *process = nullptr;
         QLineEdit *map_path;
         
+        // Parallel extraction: the map is split up so each shard has at least this many tags, into this many shards
+        // per process that can run at once
+        static constexpr qsizetype MIN_TAGS_PER_SHARD = 64;
+        static constexpr int SHARDS_PER_PROCESS = 2;
+        
+        // Windows can't start anything with a command line longer than 32767 characters, so searches are split up
+        // into several runs to stay under this
+        static constexpr qsizetype MAX_COMMAND_LINE_LENGTH = 30000;
+        
+        std::vector<QProcess *> shard_processes;
+        std::deque<QStringList> pending_shards;
+        QStringList shard_arguments;
+        bool extracting = false;
+        
+        // Show tags as they're read, but don't rebuild the tree more often than this
+        static constexpr int TAG_UPDATE_INTERVAL_MS = 250;
+        
+        QProcess *info_process = nullptr;
+        QProcess *tags_process = nullptr;
+        QStringList map_tag_list;
+        QTimer *map_tags_timer;
+        
+        // Saved to the cache once both come back
+        std::optional<MapInfoCache::Key> cache_key;
+        std::optional<QByteArray> map_summary;
+        bool map_tags_read = false;
+        
         TagTreeWidget *map_tags;
         QCheckBox *non_mp_globals;
         QCheckBox *overwrite;
         QCheckBox *ignore_resources;
         QCheckBox *use_maps_preferences;
+        QCheckBox *parallel;
         QPushButton *extract_button;
+        QPushButton *extract_selected_button;
         
         void extract_full_map();
-        void extract_map(const std::vector<std::string> &filter = std::vector<std::string>(), bool recursive = false, bool overwrite_anyway = false);
+        void extract_map(const QStringList &filter = QStringList(), bool recursive = false, bool overwrite_anyway = false);
+        void extract_selected();
+        void extract_tags(const QStringList &searches, const QString &description);
+        void extract_map_sharded();
+        void run_shards(std::vector<QStringList> shards, std::size_t process_count, QStringList arguments);
+        void start_next_shard();
+        void finish_shard(QProcess *process);
+        void stop_extraction();
+        bool extraction_running();
+        QStringList extraction_arguments(bool recursive, bool overwrite_anyway) const;
         void find_map_path();
         void reload_info();
+        void stop_info();
+        void set_map_summary(const QByteArray &summary, bool succeeded);
+        void add_map_tags(const QStringList &tags, bool finished, bool succeeded);
+        void cache_info();
         
         void set_ready(QProcess::ProcessState);
+        void update_extract_selected_button();
         
-        QString get_map_info(const char *what) const;
         void reject() override;
         
-        void double_clicked(QTreeWidgetItem *item, int column);
+        void double_clicked(const QModelIndex &index);
         void generate_index_file();
     };
 }
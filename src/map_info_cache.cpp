@@ -0,0 +1,334 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "map_info_cache.hpp"
+
+namespace SixShooter {
+    // The cache file is a header followed by each map:
+    //
+    //     u64 last used, i64 size, i64 modified, u8 protection, u8 hash length, u16 reserved, u32 path length,
+    //     u32 contents length, u32 details length, hash, path (UTF-16), contents, details
+    //
+    // Contents are zlib-compressed: u32 summary length, summary, then the tags as UTF-8, one per line. Details are
+    // engine, scenario, tag count and CRC32 as UTF-8, one per line. Everything is native byte order since it never
+    // leaves this machine.
+    struct MapInfoCacheHeader {
+        char magic[4];
+        std::uint32_t version;
+        std::uint32_t entry_count;
+        std::uint32_t reserved;
+    };
+
+    struct MapInfoCacheEntryHeader {
+        std::uint64_t last_used;
+        qint64 size;
+        qint64 modified;
+        std::uint8_t protection;
+        std::uint8_t hash_length;
+        std::uint16_t reserved;
+        std::uint32_t path_length;
+        std::uint32_t contents_length;
+        std::uint32_t details_length;
+    };
+
+    static constexpr char MAP_INFO_CACHE_MAGIC[4] = { 'S', 'S', 'M', 'I' };
+    static constexpr std::uint32_t MAP_INFO_CACHE_VERSION = 2;
+
+    template<typename T> static void write_value(QByteArray &data, const T &value) {
+        data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    static QByteArray pack_contents(const QByteArray &summary, const QStringList &tags) {
+        QByteArray data;
+        write_value(data, static_cast<std::uint32_t>(summary.size()));
+        data.append(summary);
+        data.append(tags.join('\n').toUtf8());
+        return qCompress(data);
+    }
+
+    static bool unpack_contents(const QByteArray &contents, QByteArray &summary, QStringList &tags) {
+        auto data = qUncompress(contents);
+        std::uint32_t summary_length;
+        if(data.size() < static_cast<qsizetype>(sizeof(summary_length))) {
+            return false;
+        }
+        std::memcpy(&summary_length, data.constData(), sizeof(summary_length));
+        if(data.size() - static_cast<qsizetype>(sizeof(summary_length)) < static_cast<qsizetype>(summary_length)) {
+            return false;
+        }
+
+        summary = data.mid(sizeof(summary_length), summary_length);
+        auto tags_data = data.mid(sizeof(summary_length) + summary_length);
+        tags = tags_data.isEmpty() ? QStringList() : QString::fromUtf8(tags_data).split('\n');
+        return true;
+    }
+
+    static QByteArray pack_details(const MapInfoCache::Details &details) {
+        return QStringList({ details.engine, details.scenario, QString::number(details.tag_count), details.crc32 }).join('\n').toUtf8();
+    }
+
+    static bool unpack_details(const QByteArray &data, MapInfoCache::Details &details) {
+        auto fields = QString::fromUtf8(data).split('\n');
+        if(fields.size() != 4) {
+            return false;
+        }
+        details.engine = fields[0];
+        details.scenario = fields[1];
+        details.tag_count = fields[2].toLongLong();
+        details.crc32 = fields[3];
+        return true;
+    }
+
+    MapInfoCache::MapInfoCache() {
+        this->save_timer.setSingleShot(true);
+        this->save_timer.setInterval(SAVE_DELAY_MS);
+        QObject::connect(&this->save_timer, &QTimer::timeout, &this->save_timer, [this]() {
+            if(this->dirty) {
+                this->save();
+            }
+        });
+    }
+
+    MapInfoCache::~MapInfoCache() {
+        // Anything that wasn't saved yet, even if it's just last-used times
+        if(this->dirty) {
+            this->save();
+        }
+    }
+
+    std::optional<MapInfoCache::Key> MapInfoCache::make_key(const std::filesystem::path &map) {
+        std::error_code error;
+        auto absolute = std::filesystem::absolute(map, error);
+        if(error) {
+            return std::nullopt;
+        }
+
+        auto modified = std::filesystem::last_write_time(absolute, error);
+        if(error) {
+            return std::nullopt;
+        }
+
+        QFile file(QString::fromStdU16String(absolute.u16string()));
+        if(!file.open(QIODevice::OpenModeFlag::ReadOnly)) {
+            return std::nullopt;
+        }
+
+        // Small maps are hashed whole; otherwise the start (header and tag data, usually), the middle and the end
+        QCryptographicHash hash(QCryptographicHash::Algorithm::Sha1);
+        auto size = file.size();
+        if(size <= HASH_SAMPLE_SIZE * 3) {
+            hash.addData(file.readAll());
+        }
+        else {
+            for(auto offset : { static_cast<qint64>(0), (size - HASH_SAMPLE_SIZE) / 2, size - HASH_SAMPLE_SIZE }) {
+                if(!file.seek(offset)) {
+                    return std::nullopt;
+                }
+                hash.addData(file.read(HASH_SAMPLE_SIZE));
+            }
+        }
+
+        return Key { QString::fromStdU16String(absolute.u16string()), size, static_cast<qint64>(modified.time_since_epoch().count()), hash.result() };
+    }
+
+    std::optional<MapInfoCache::Info> MapInfoCache::find(const Key &key) {
+        this->load();
+
+        auto entry = this->entries.find(key.path);
+        if(entry == this->entries.end() || entry->size != key.size || entry->modified != key.modified || entry->hash != key.hash) {
+            return std::nullopt;
+        }
+
+        entry->last_used = ++this->clock;
+        this->dirty = true;
+
+        Info info;
+        info.protection = entry->protection;
+        if(!entry->contents.isEmpty()) {
+            info.has_contents = unpack_contents(entry->contents, info.summary, info.tags);
+        }
+        if(!entry->details.isEmpty()) {
+            info.has_details = unpack_details(entry->details, info.details);
+        }
+        return info;
+    }
+
+    void MapInfoCache::set_protection(const Key &key, Protection protection) {
+        this->entry_for(key).protection = protection;
+        this->changed();
+    }
+
+    void MapInfoCache::set_contents(const Key &key, const QByteArray &summary, const QStringList &tags) {
+        this->entry_for(key).contents = pack_contents(summary, tags);
+        this->changed();
+    }
+
+    void MapInfoCache::set_details(const Key &key, const Details &details) {
+        this->entry_for(key).details = pack_details(details);
+        this->changed();
+    }
+
+    MapInfoCache::Entry &MapInfoCache::entry_for(const Key &key) {
+        this->load();
+
+        auto &entry = this->entries[key.path];
+        if(entry.size != key.size || entry.modified != key.modified || entry.hash != key.hash) {
+            entry = Entry { key.size, key.modified, key.hash, 0, Protection::Unknown, QByteArray(), QByteArray() };
+        }
+        entry.last_used = ++this->clock;
+        return entry;
+    }
+
+    void MapInfoCache::changed() {
+        // Saving means writing out the whole cache, so do it once for a bunch of changes
+        this->dirty = true;
+        if(!this->save_timer.isActive()) {
+            this->save_timer.start();
+        }
+    }
+
+    qint64 MapInfoCache::entry_size(const QString &path, const Entry &entry) noexcept {
+        return static_cast<qint64>(sizeof(MapInfoCacheEntryHeader)) + entry.hash.size() + path.size() * static_cast<qint64>(sizeof(char16_t)) + entry.contents.size() + entry.details.size();
+    }
+
+    void MapInfoCache::evict() {
+        std::vector<std::pair<std::uint64_t, QString>> by_use;
+        qint64 total = sizeof(MapInfoCacheHeader);
+        for(auto i = this->entries.cbegin(); i != this->entries.cend(); i++) {
+            by_use.emplace_back(i->last_used, i.key());
+            total += entry_size(i.key(), i.value());
+        }
+
+        if(total <= MAX_CACHE_SIZE) {
+            return;
+        }
+
+        // Oldest first
+        std::sort(by_use.begin(), by_use.end());
+        for(auto &[last_used, path] : by_use) {
+            if(total <= MAX_CACHE_SIZE) {
+                break;
+            }
+            total -= entry_size(path, this->entries[path]);
+            this->entries.remove(path);
+        }
+    }
+
+    QString MapInfoCache::get_cache_path() {
+        return QDir(QStandardPaths::writableLocation(QStandardPaths::StandardLocation::AppDataLocation)).filePath("map_info.bin");
+    }
+
+    void MapInfoCache::load() {
+        if(this->loaded) {
+            return;
+        }
+        this->loaded = true;
+
+        QFile file(get_cache_path());
+        if(!file.open(QIODevice::OpenModeFlag::ReadOnly)) {
+            return;
+        }
+
+        auto data = file.readAll();
+        qsizetype offset = 0;
+        auto read = [&data, &offset](void *value, qsizetype size) {
+            if(data.size() - offset < size) {
+                return false;
+            }
+            std::memcpy(value, data.constData() + offset, size);
+            offset += size;
+            return true;
+        };
+
+        MapInfoCacheHeader header;
+        if(!read(&header, sizeof(header)) || std::memcmp(header.magic, MAP_INFO_CACHE_MAGIC, sizeof(header.magic)) != 0 || header.version != MAP_INFO_CACHE_VERSION) {
+            return;
+        }
+
+        for(std::uint32_t i = 0; i < header.entry_count; i++) {
+            MapInfoCacheEntryHeader entry_header;
+            if(!read(&entry_header, sizeof(entry_header))) {
+                break;
+            }
+
+            auto path_bytes = static_cast<qsizetype>(entry_header.path_length) * static_cast<qsizetype>(sizeof(char16_t));
+            if(data.size() - offset < entry_header.hash_length + path_bytes + static_cast<qsizetype>(entry_header.contents_length) + static_cast<qsizetype>(entry_header.details_length)) {
+                break;
+            }
+
+            Entry entry;
+            entry.last_used = entry_header.last_used;
+            entry.size = entry_header.size;
+            entry.modified = entry_header.modified;
+            entry.protection = entry_header.protection <= Protection::Protected ? static_cast<Protection>(entry_header.protection) : Protection::Unknown;
+            entry.hash = data.mid(offset, entry_header.hash_length);
+            offset += entry_header.hash_length;
+
+            QString path(static_cast<qsizetype>(entry_header.path_length), Qt::Uninitialized);
+            std::memcpy(path.data(), data.constData() + offset, path_bytes);
+            offset += path_bytes;
+
+            entry.contents = data.mid(offset, entry_header.contents_length);
+            offset += entry_header.contents_length;
+
+            entry.details = data.mid(offset, entry_header.details_length);
+            offset += entry_header.details_length;
+
+            this->clock = std::max(this->clock, entry.last_used);
+            this->entries.insert(path, std::move(entry));
+        }
+    }
+
+    void MapInfoCache::save() {
+        this->evict();
+
+        QByteArray data;
+
+        MapInfoCacheHeader header = {};
+        std::memcpy(header.magic, MAP_INFO_CACHE_MAGIC, sizeof(header.magic));
+        header.version = MAP_INFO_CACHE_VERSION;
+        header.entry_count = static_cast<std::uint32_t>(this->entries.size());
+        write_value(data, header);
+
+        for(auto i = this->entries.cbegin(); i != this->entries.cend(); i++) {
+            auto &entry = i.value();
+
+            MapInfoCacheEntryHeader entry_header = {};
+            entry_header.last_used = entry.last_used;
+            entry_header.size = entry.size;
+            entry_header.modified = entry.modified;
+            entry_header.protection = entry.protection;
+            entry_header.hash_length = static_cast<std::uint8_t>(entry.hash.size());
+            entry_header.path_length = static_cast<std::uint32_t>(i.key().size());
+            entry_header.contents_length = static_cast<std::uint32_t>(entry.contents.size());
+            entry_header.details_length = static_cast<std::uint32_t>(entry.details.size());
+            write_value(data, entry_header);
+
+            data.append(entry.hash);
+            data.append(reinterpret_cast<const char *>(i.key().utf16()), i.key().size() * sizeof(char16_t));
+            data.append(entry.contents);
+            data.append(entry.details);
+        }
+
+        // Write to a temporary file first so a crash can't leave a half-written cache
+        auto path = get_cache_path();
+        QDir().mkpath(QFileInfo(path).absolutePath());
+        QSaveFile file(path);
+        if(!file.open(QIODevice::OpenModeFlag::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+            std::fprintf(stderr, "Failed to write %s\n", path.toLocal8Bit().data());
+            return;
+        }
+
+        this->dirty = false;
+    }
+}
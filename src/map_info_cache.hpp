@@ -0,0 +1,113 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SIX_SHOOTER_MAP_INFO_CACHE_HPP
+#define SIX_SHOOTER_MAP_INFO_CACHE_HPP
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+
+namespace SixShooter {
+    // What invader-info said about maps that were opened before, kept on disk between runs so reopening a map doesn't
+    // have to read it all over again.
+    //
+    // Maps are told apart by path, size, mtime and a hash of a few samples of their contents, so a map that was
+    // replaced with a different one of the same size doesn't get someone else's info. The least recently used maps
+    // are dropped once the cache gets too big. GUI thread only.
+    class MapInfoCache {
+    public:
+        // Keep the file (and what's kept in memory) under this many bytes
+        static constexpr qint64 MAX_CACHE_SIZE = 8 * 1024 * 1024;
+
+        // Bytes hashed from the start, the middle and the end of a map
+        static constexpr qint64 HASH_SAMPLE_SIZE = 64 * 1024;
+
+        // Changes are saved together this long after the first one (or on exit, whichever is first)
+        static constexpr int SAVE_DELAY_MS = 2000;
+
+        enum Protection : std::uint8_t {
+            Unknown,
+            Unprotected,
+            Protected
+        };
+
+        struct Key {
+            QString path;
+            qint64 size;
+            qint64 modified;
+            QByteArray hash;
+        };
+
+        // What the maps browser shows
+        struct Details {
+            QString engine;
+            QString scenario;
+            qint64 tag_count = -1;
+            QString crc32;
+        };
+
+        struct Info {
+            Protection protection = Protection::Unknown;
+
+            bool has_details = false;
+            Details details;
+
+            // Output of invader-info (with colors) and the list of tags, if they were stored
+            bool has_contents = false;
+            QByteArray summary;
+            QStringList tags;
+        };
+
+        MapInfoCache();
+        ~MapInfoCache();
+
+        // Identify a map; fails if it can't be read
+        static std::optional<Key> make_key(const std::filesystem::path &map);
+
+        // Anything stored for this exact map
+        std::optional<Info> find(const Key &key);
+
+        // Store what's known; anything stored earlier for a map that's since changed is thrown out
+        void set_protection(const Key &key, Protection protection);
+        void set_contents(const Key &key, const QByteArray &summary, const QStringList &tags);
+        void set_details(const Key &key, const Details &details);
+
+    private:
+        struct Entry {
+            qint64 size = -1;
+            qint64 modified = 0;
+            QByteArray hash;
+            std::uint64_t last_used = 0;
+            Protection protection = Protection::Unknown;
+
+            // Compressed summary and tags, or empty if not stored
+            QByteArray contents;
+
+            // Packed details, or empty if not stored
+            QByteArray details;
+        };
+
+        Entry &entry_for(const Key &key);
+        void changed();
+        void evict();
+        void load();
+        void save();
+
+        static QString get_cache_path();
+        static qint64 entry_size(const QString &path, const Entry &entry) noexcept;
+
+        // Keyed by absolute path
+        QHash<QString, Entry> entries;
+        std::uint64_t clock = 0;
+        bool loaded = false;
+        bool dirty = false;
+        QTimer save_timer;
+    };
+}
+
+#endif
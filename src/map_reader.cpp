@@ -0,0 +1,305 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <QHash>
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+#include <unordered_set>
+
+#include "map_reader.hpp"
+
+namespace SixShooter {
+    // Everything here is little endian, which is what every platform this runs on is
+    static constexpr std::uint32_t fourcc(const char (&code)[5]) noexcept {
+        return (static_cast<std::uint32_t>(static_cast<std::uint8_t>(code[0])) << 24) |
+               (static_cast<std::uint32_t>(static_cast<std::uint8_t>(code[1])) << 16) |
+               (static_cast<std::uint32_t>(static_cast<std::uint8_t>(code[2])) << 8) |
+               static_cast<std::uint32_t>(static_cast<std::uint8_t>(code[3]));
+    }
+
+    // Cache file header
+    static constexpr std::size_t HEADER_SIZE = 0x800;
+    static constexpr std::size_t HEADER_HEAD_LITERAL = 0x0;
+    static constexpr std::size_t HEADER_ENGINE = 0x4;
+    static constexpr std::size_t HEADER_FILE_SIZE = 0x8;
+    static constexpr std::size_t HEADER_TAG_DATA_OFFSET = 0x10;
+    static constexpr std::size_t HEADER_TAG_DATA_SIZE = 0x14;
+    static constexpr std::size_t HEADER_NAME = 0x20;
+    static constexpr std::size_t HEADER_NAME_LENGTH = 32;
+    static constexpr std::size_t HEADER_FOOT_LITERAL = 0x7FC;
+
+    // Tag data header, at the start of the tag data
+    static constexpr std::size_t TAG_DATA_HEADER_SIZE = 0x28;
+    static constexpr std::size_t TAG_DATA_TAG_ARRAY = 0x0;
+    static constexpr std::size_t TAG_DATA_TAG_COUNT = 0xC;
+    static constexpr std::size_t TAG_DATA_TAGS_LITERAL = 0x24;
+
+    // Tag array entries
+    static constexpr std::size_t TAG_ENTRY_SIZE = 0x20;
+    static constexpr std::size_t TAG_ENTRY_CLASS = 0x0;
+    static constexpr std::size_t TAG_ENTRY_PATH = 0x10;
+
+    // Longest path that gets looked for; anything longer is treated as broken
+    static constexpr std::size_t MAX_PATH_LENGTH = 256;
+
+    struct Engine {
+        std::uint32_t version;
+        const char *name;
+    };
+
+    // Xbox maps are compressed and demo maps have a different header, so invader-info handles those
+    static constexpr Engine ENGINES[] = {
+        { 7, "Halo: Combat Evolved (PC)" },
+        { 609, "Halo Custom Edition" },
+        { 13, "Halo: Combat Evolved Anniversary (MCC)" }
+    };
+
+    struct TagClass {
+        std::uint32_t fourcc;
+        const char *name;
+    };
+
+    static const TagClass TAG_CLASSES[] = {
+        { fourcc("actr"), "actor" },
+        { fourcc("actv"), "actor_variant" },
+        { fourcc("ant!"), "antenna" },
+        { fourcc("antr"), "model_animations" },
+        { fourcc("bipd"), "biped" },
+        { fourcc("bitm"), "bitmap" },
+        { fourcc("boom"), "spheroid" },
+        { fourcc("cdmg"), "continuous_damage_effect" },
+        { fourcc("coll"), "model_collision_geometry" },
+        { fourcc("colo"), "color_table" },
+        { fourcc("cont"), "contrail" },
+        { fourcc("ctrl"), "device_control" },
+        { fourcc("deca"), "decal" },
+        { fourcc("DeLa"), "ui_widget_definition" },
+        { fourcc("devc"), "input_device_defaults" },
+        { fourcc("devi"), "device" },
+        { fourcc("dobc"), "detail_object_collection" },
+        { fourcc("effe"), "effect" },
+        { fourcc("elec"), "lightning" },
+        { fourcc("eqip"), "equipment" },
+        { fourcc("flag"), "flag" },
+        { fourcc("fog "), "fog" },
+        { fourcc("font"), "font" },
+        { fourcc("foot"), "material_effects" },
+        { fourcc("garb"), "garbage" },
+        { fourcc("glw!"), "glow" },
+        { fourcc("grhi"), "grenade_hud_interface" },
+        { fourcc("hmt "), "hud_message_text" },
+        { fourcc("hud#"), "hud_number" },
+        { fourcc("hudg"), "hud_globals" },
+        { fourcc("item"), "item" },
+        { fourcc("itmc"), "item_collection" },
+        { fourcc("jpt!"), "damage_effect" },
+        { fourcc("lens"), "lens_flare" },
+        { fourcc("lifi"), "device_light_fixture" },
+        { fourcc("ligh"), "light" },
+        { fourcc("lsnd"), "sound_looping" },
+        { fourcc("mach"), "device_machine" },
+        { fourcc("matg"), "globals" },
+        { fourcc("metr"), "meter" },
+        { fourcc("mgs2"), "light_volume" },
+        { fourcc("mod2"), "gbxmodel" },
+        { fourcc("mode"), "model" },
+        { fourcc("mply"), "multiplayer_scenario_description" },
+        { fourcc("ngpr"), "preferences_network_game" },
+        { fourcc("obje"), "object" },
+        { fourcc("part"), "particle" },
+        { fourcc("pctl"), "particle_system" },
+        { fourcc("phys"), "physics" },
+        { fourcc("plac"), "placeholder" },
+        { fourcc("pphy"), "point_physics" },
+        { fourcc("proj"), "projectile" },
+        { fourcc("rain"), "weather_particle_system" },
+        { fourcc("sbsp"), "scenario_structure_bsp" },
+        { fourcc("scen"), "scenery" },
+        { fourcc("scex"), "shader_transparent_chicago_extended" },
+        { fourcc("schi"), "shader_transparent_chicago" },
+        { fourcc("scnr"), "scenario" },
+        { fourcc("senv"), "shader_environment" },
+        { fourcc("sgla"), "shader_transparent_glass" },
+        { fourcc("shdr"), "shader" },
+        { fourcc("sky "), "sky" },
+        { fourcc("smet"), "shader_transparent_meter" },
+        { fourcc("snd!"), "sound" },
+        { fourcc("snde"), "sound_environment" },
+        { fourcc("soso"), "shader_model" },
+        { fourcc("sotr"), "shader_transparent_generic" },
+        { fourcc("Soul"), "ui_widget_collection" },
+        { fourcc("spla"), "shader_transparent_plasma" },
+        { fourcc("ssce"), "sound_scenery" },
+        { fourcc("str#"), "string_list" },
+        { fourcc("swat"), "shader_transparent_water" },
+        { fourcc("tagc"), "tag_collection" },
+        { fourcc("trak"), "camera_track" },
+        { fourcc("udlg"), "dialogue" },
+        { fourcc("unhi"), "unit_hud_interface" },
+        { fourcc("unit"), "unit" },
+        { fourcc("ustr"), "unicode_string_list" },
+        { fourcc("vcky"), "virtual_keyboard" },
+        { fourcc("vehi"), "vehicle" },
+        { fourcc("weap"), "weapon" },
+        { fourcc("wind"), "wind" },
+        { fourcc("wphi"), "weapon_hud_interface" }
+    };
+
+    static const char *tag_class_name(std::uint32_t tag_class) noexcept {
+        // Built once; there are only a few dozen
+        static const auto names = []() {
+            QHash<std::uint32_t, const char *> names;
+            for(auto &i : TAG_CLASSES) {
+                names.insert(i.fourcc, i.name);
+            }
+            return names;
+        }();
+        return names.value(tag_class, nullptr);
+    }
+
+    MapReader::MapReader(const std::filesystem::path &map) : file(map.string().c_str()) {
+        if(!this->file.open(QIODevice::OpenModeFlag::ReadOnly) || this->file.size() < static_cast<qint64>(HEADER_SIZE)) {
+            return;
+        }
+
+        this->size = this->file.size();
+        this->data = this->file.map(0, this->size);
+        if(this->data == nullptr) {
+            return;
+        }
+
+        if(!this->read()) {
+            this->file.unmap(this->data);
+            this->data = nullptr;
+            this->tags.clear();
+        }
+    }
+
+    bool MapReader::read() {
+        auto read_u32 = [this](std::size_t offset) {
+            std::uint32_t value;
+            std::memcpy(&value, this->data + offset, sizeof(value));
+            return value;
+        };
+
+        // Header; anything compressed has a bigger size in the header than the file
+        if(read_u32(HEADER_HEAD_LITERAL) != fourcc("head") || read_u32(HEADER_FOOT_LITERAL) != fourcc("foot") || read_u32(HEADER_FILE_SIZE) != static_cast<std::uint64_t>(this->size)) {
+            return false;
+        }
+
+        auto version = read_u32(HEADER_ENGINE);
+        for(auto &i : ENGINES) {
+            if(i.version == version) {
+                this->engine = i.name;
+            }
+        }
+        if(this->engine == nullptr) {
+            return false;
+        }
+
+        // Tag data
+        std::uint64_t tag_data_offset = read_u32(HEADER_TAG_DATA_OFFSET);
+        std::uint64_t tag_data_size = read_u32(HEADER_TAG_DATA_SIZE);
+        if(tag_data_size < TAG_DATA_HEADER_SIZE || tag_data_offset + tag_data_size > static_cast<std::uint64_t>(this->size)) {
+            return false;
+        }
+        if(read_u32(tag_data_offset + TAG_DATA_TAGS_LITERAL) != fourcc("tags")) {
+            return false;
+        }
+
+        // Tag data is loaded at a fixed address that depends on the engine; the tag array comes right after the tag
+        // data header, so that's where the tag data starts in memory
+        std::uint64_t tag_array = read_u32(tag_data_offset + TAG_DATA_TAG_ARRAY);
+        if(tag_array < TAG_DATA_HEADER_SIZE) {
+            return false;
+        }
+        auto base_address = tag_array - TAG_DATA_HEADER_SIZE;
+        auto *tag_data = this->data + tag_data_offset;
+
+        // Find where a pointer points in the tag data, or return false if it's outside of it
+        auto translate = [base_address, tag_data_size](std::uint64_t address, std::uint64_t length, std::uint64_t &offset) {
+            if(address < base_address || address - base_address > tag_data_size || tag_data_size - (address - base_address) < length) {
+                return false;
+            }
+            offset = address - base_address;
+            return true;
+        };
+
+        std::uint64_t tag_count = read_u32(tag_data_offset + TAG_DATA_TAG_COUNT);
+        std::uint64_t tag_array_offset;
+        if(!translate(tag_array, tag_count * TAG_ENTRY_SIZE, tag_array_offset)) {
+            return false;
+        }
+
+        // Hash paths with their class to find duplicates
+        struct TagKey {
+            std::string_view path;
+            std::uint32_t tag_class;
+            bool operator==(const TagKey &other) const noexcept {
+                return this->path == other.path && this->tag_class == other.tag_class;
+            }
+        };
+        struct TagKeyHash {
+            std::size_t operator()(const TagKey &key) const noexcept {
+                return std::hash<std::string_view>()(key.path) ^ key.tag_class;
+            }
+        };
+        std::unordered_set<TagKey, TagKeyHash> seen;
+        seen.reserve(tag_count);
+
+        this->tags.reserve(tag_count);
+        for(std::uint64_t i = 0; i < tag_count; i++) {
+            auto *entry = tag_data + tag_array_offset + i * TAG_ENTRY_SIZE;
+            std::uint32_t primary_class, path_address;
+            std::memcpy(&primary_class, entry + TAG_ENTRY_CLASS, sizeof(primary_class));
+            std::memcpy(&path_address, entry + TAG_ENTRY_PATH, sizeof(path_address));
+
+            // A class we don't know means it's not a map we understand
+            auto *tag_class = tag_class_name(primary_class);
+            if(tag_class == nullptr) {
+                return false;
+            }
+
+            std::uint64_t path_offset;
+            if(!translate(path_address, 1, path_offset)) {
+                return false;
+            }
+
+            // Paths are null-terminated
+            auto *path = reinterpret_cast<const char *>(tag_data + path_offset);
+            auto max_length = std::min<std::uint64_t>(tag_data_size - path_offset, MAX_PATH_LENGTH);
+            auto *end = static_cast<const char *>(std::memchr(path, 0, max_length));
+            if(end == nullptr) {
+                return false;
+            }
+            std::string_view path_view(path, end - path);
+
+            bool printable = !path_view.empty();
+            for(auto c : path_view) {
+                printable = printable && c >= 0x20 && c < 0x7F;
+            }
+            if(!printable || !seen.insert(TagKey { path_view, primary_class }).second) {
+                this->protection_detected = true;
+            }
+
+            this->tags.emplace_back(Tag { QLatin1String(path_view.data(), static_cast<qsizetype>(path_view.size())), tag_class });
+        }
+
+        return true;
+    }
+
+    QString MapReader::get_scenario_name() const {
+        auto *name = reinterpret_cast<const char *>(this->data + HEADER_NAME);
+        auto *end = static_cast<const char *>(std::memchr(name, 0, HEADER_NAME_LENGTH));
+        return QString::fromLatin1(name, end == nullptr ? static_cast<qsizetype>(HEADER_NAME_LENGTH) : end - name);
+    }
+
+    QStringList MapReader::get_tags() const {
+        QStringList list;
+        list.reserve(static_cast<qsizetype>(this->tags.size()));
+        for(auto &tag : this->tags) {
+            list << QString(tag.path) + "." + tag.tag_class;
+        }
+        return list;
+    }
+}
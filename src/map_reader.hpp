@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SIX_SHOOTER_MAP_READER_HPP
+#define SIX_SHOOTER_MAP_READER_HPP
+
+#include <QFile>
+#include <QLatin1String>
+#include <QStringList>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace SixShooter {
+    // Reads the header and tag index of a map directly instead of asking invader-info, which is much faster.
+    //
+    // Only uncompressed PC maps (retail, Custom Edition and uncompressed MCC) are read. Anything else, or anything
+    // that doesn't look quite right, isn't opened at all so callers can fall back to invader-info. The map is
+    // memory-mapped and tag paths point straight into it, so the reader has to stay around while they're used.
+    class MapReader {
+    public:
+        MapReader(const std::filesystem::path &map);
+
+        bool is_open() const noexcept {
+            return this->data != nullptr;
+        }
+
+        // Name of the engine the map was built for
+        const char *get_engine() const noexcept {
+            return this->engine;
+        }
+
+        // Scenario name in the header (e.g. "bloodgulch")
+        QString get_scenario_name() const;
+
+        std::size_t get_tag_count() const noexcept {
+            return this->tags.size();
+        }
+
+        QLatin1String get_tag_path(std::size_t tag) const noexcept {
+            return this->tags[tag].path;
+        }
+
+        // Class name, which is also the extension (e.g. "scenario")
+        const char *get_tag_class(std::size_t tag) const noexcept {
+            return this->tags[tag].tag_class;
+        }
+
+        // Every tag as "path.class", in the same order invader-info lists them
+        QStringList get_tags() const;
+
+        // Whether tag paths look like a map protection tool got to them: blank, unprintable or duplicated paths
+        bool is_protected() const noexcept {
+            return this->protection_detected;
+        }
+
+    private:
+        struct Tag {
+            QLatin1String path;
+            const char *tag_class;
+        };
+
+        bool read();
+
+        QFile file;
+        uchar *data = nullptr;
+        qint64 size = 0;
+
+        const char *engine = nullptr;
+        std::vector<Tag> tags;
+        bool protection_detected = false;
+    };
+}
+
+#endif
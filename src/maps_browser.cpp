@@ -0,0 +1,305 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <QVBoxLayout>
+#include <QLabel>
+#include <QTableWidget>
+#include <QHeaderView>
+#include <QProcess>
+#include <QThread>
+#include <QDir>
+#include <QScreen>
+#include <QGuiApplication>
+#include <algorithm>
+
+#include "main_window.hpp"
+#include "map_reader.hpp"
+#include "maps_browser.hpp"
+
+namespace SixShooter {
+    static const char *DETAIL_QUERIES[] = { "engine", "scenario", "tag_count", "crc32" };
+
+    MapsBrowser::MapsBrowser(const MainWindow *main_window) : main_window(main_window) {
+        auto *layout = new QVBoxLayout(this);
+        auto maps_directory = std::filesystem::absolute(this->main_window->get_maps_directory());
+        this->setWindowTitle(QString(maps_directory.string().c_str()) + " - Maps - Six Shooter");
+
+        this->table = new QTableWidget(this);
+        this->table->setColumnCount(Column::ColumnCount);
+        this->table->setHorizontalHeaderLabels(QStringList() << "Map" << "Engine" << "Scenario" << "Tags" << "Protected" << "CRC32" << "Size (MiB)");
+        this->table->setEditTriggers(QAbstractItemView::EditTrigger::NoEditTriggers);
+        this->table->setSelectionBehavior(QAbstractItemView::SelectionBehavior::SelectRows);
+        this->table->setWordWrap(false);
+        this->table->verticalHeader()->hide();
+        this->table->verticalHeader()->setDefaultSectionSize(this->table->fontMetrics().height() + 2);
+        this->table->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeMode::Interactive);
+        this->table->horizontalHeader()->setStretchLastSection(true);
+        layout->addWidget(this->table);
+
+        this->status = new QLabel(this);
+        layout->addWidget(this->status);
+
+        // List everything right away; the rest gets filled in as it comes
+        auto files = QDir(maps_directory.string().c_str()).entryInfoList(QStringList("*.map"), QDir::Filter::Files, QDir::SortFlag::Name | QDir::SortFlag::IgnoreCase);
+        this->maps.resize(files.size());
+        this->table->setRowCount(files.size());
+
+        QStringList paths;
+        for(qsizetype i = 0; i < files.size(); i++) {
+            auto &map = this->maps[i];
+            map.path = files[i].absoluteFilePath();
+            paths << map.path;
+
+            for(int c = 0; c < Column::ColumnCount; c++) {
+                map.items[c] = new QTableWidgetItem();
+                this->table->setItem(i, c, map.items[c]);
+            }
+            map.items[Column::Name]->setText(files[i].fileName());
+            map.items[Column::Name]->setToolTip(map.path);
+            map.items[Column::Size]->setData(Qt::DisplayRole, qRound(files[i].size() / 1024.0 / 1024.0 * 10.0) / 10.0);
+            map.items[Column::TagCount]->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            map.items[Column::Size]->setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+            this->update_map(map);
+        }
+
+        auto metrics = this->table->fontMetrics();
+        this->table->setColumnWidth(Column::Name, metrics.horizontalAdvance("x") * 28);
+        this->table->setColumnWidth(Column::Scenario, metrics.horizontalAdvance("x") * 24);
+        // Sorting as each result comes in would re-sort the whole table every time, so it's only turned on once
+        // everything's in (see update_status); until then, clicking a header sorts once
+        auto *header = this->table->horizontalHeader();
+        header->setSectionsClickable(true);
+        header->setSortIndicatorShown(true);
+        connect(header, &QHeaderView::sortIndicatorChanged, this, [this](int column, Qt::SortOrder order) {
+            if(!this->table->isSortingEnabled()) {
+                this->table->sortItems(column, order);
+            }
+        });
+        header->setSortIndicator(Column::Name, Qt::SortOrder::AscendingOrder);
+        this->table->sortItems(Column::Name, Qt::SortOrder::AscendingOrder);
+
+        // Hand each map back as soon as it's identified
+        this->key_thread = QThread::create([this, paths]() {
+            for(qsizetype i = 0; i < paths.size() && !QThread::currentThread()->isInterruptionRequested(); i++) {
+                auto key = MapInfoCache::make_key(paths[i].toStdString());
+
+                std::optional<NativeInfo> native;
+                MapReader reader(paths[i].toStdString());
+                if(reader.is_open()) {
+                    auto &info = native.emplace();
+                    info.details.engine = reader.get_engine();
+                    info.details.scenario = reader.get_scenario_name();
+                    info.details.tag_count = static_cast<qint64>(reader.get_tag_count());
+                    info.protection = reader.is_protected() ? MapInfoCache::Protection::Protected : MapInfoCache::Protection::Unprotected;
+                }
+
+                QMetaObject::invokeMethod(this, [this, i, key, native]() {
+                    this->set_key(i, key, native);
+                }, Qt::ConnectionType::QueuedConnection);
+            }
+        });
+        this->key_thread->start();
+
+        this->update_status();
+
+        auto screen_geometry = QGuiApplication::primaryScreen()->geometry();
+        this->setGeometry(
+            QStyle::alignedRect(
+                Qt::LeftToRight,
+                Qt::AlignCenter,
+                QSize(screen_geometry.width() / 5 * 3, screen_geometry.height() / 5 * 3),
+                screen_geometry
+            )
+        );
+    }
+
+    MapsBrowser::~MapsBrowser() {
+        this->key_thread->requestInterruption();
+        this->key_thread->wait();
+        delete this->key_thread;
+
+        // Don't hear back from anything still running
+        for(auto *process : this->processes) {
+            disconnect(process, nullptr, this, nullptr);
+            process->kill();
+            process->waitForFinished(-1);
+        }
+    }
+
+    void MapsBrowser::set_key(std::size_t index, const std::optional<MapInfoCache::Key> &key, const std::optional<NativeInfo> &native) {
+        auto &map = this->maps[index];
+        map.key = key;
+
+        // Whatever's cached doesn't need to be looked up
+        bool has_details = false;
+        if(key.has_value()) {
+            auto cached = this->main_window->get_map_info_cache()->find(*key);
+            if(cached.has_value()) {
+                map.protection = cached->protection;
+                if(cached->has_details) {
+                    map.details = cached->details;
+                    has_details = true;
+                }
+            }
+        }
+
+        // Only the CRC32 needs invader-info if the map could be read directly
+        if(!has_details) {
+            map.details_queried = true;
+            if(native.has_value()) {
+                map.details = native->details;
+                this->queries.emplace_back(Query { index, "crc32" });
+                map.pending++;
+            }
+            else {
+                for(auto *type : DETAIL_QUERIES) {
+                    this->queries.emplace_back(Query { index, type });
+                    map.pending++;
+                }
+            }
+        }
+
+        if(map.protection == MapInfoCache::Protection::Unknown) {
+            map.protection_queried = true;
+            if(native.has_value()) {
+                map.protection = native->protection;
+            }
+            else {
+                this->queries.emplace_back(Query { index, "is_protected" });
+                map.pending++;
+            }
+        }
+
+        this->update_map(map);
+        if(map.pending == 0) {
+            this->finish_map(map);
+        }
+
+        this->run_queries();
+    }
+
+    void MapsBrowser::run_queries() {
+        auto max_processes = static_cast<std::size_t>(std::max(1, QThread::idealThreadCount()));
+
+        while(this->processes.size() < max_processes && !this->queries.empty()) {
+            auto query = this->queries.front();
+            this->queries.pop_front();
+
+            auto *process = new QProcess(this);
+            process->setProgram(this->main_window->executable_path("invader-info").string().c_str());
+            process->setArguments(QStringList() << "--type" << query.type << this->maps[query.map].path);
+
+            auto done = [this, process, query](int exit_code) {
+                this->processes.erase(std::find(this->processes.begin(), this->processes.end(), process));
+                auto output = QString(process->readAllStandardOutput()).replace("\r", "").trimmed();
+                process->deleteLater();
+
+                this->set_result(query, exit_code, output);
+                this->run_queries();
+            };
+            connect(process, &QProcess::finished, this, [done](int exit_code, QProcess::ExitStatus exit_status) {
+                done(exit_status == QProcess::ExitStatus::NormalExit ? exit_code : -1);
+            });
+            connect(process, &QProcess::errorOccurred, this, [done](QProcess::ProcessError error) {
+                if(error == QProcess::ProcessError::FailedToStart) {
+                    done(-1);
+                }
+            });
+
+            this->processes.emplace_back(process);
+            process->start();
+        }
+    }
+
+    void MapsBrowser::set_result(const Query &query, int exit_code, const QString &output) {
+        auto &map = this->maps[query.map];
+        auto type = QString(query.type);
+
+        if(type == "is_protected") {
+            // 1 means it couldn't be read at all
+            if(exit_code == 1) {
+                map.invalid = true;
+                map.failed = true;
+            }
+            else if(exit_code == 0) {
+                map.protection = output.toInt() == 1 ? MapInfoCache::Protection::Protected : MapInfoCache::Protection::Unprotected;
+            }
+            else {
+                map.failed = true;
+            }
+        }
+        else if(exit_code != 0) {
+            map.failed = true;
+        }
+        else if(type == "engine") {
+            map.details.engine = output;
+        }
+        else if(type == "scenario") {
+            map.details.scenario = output;
+        }
+        else if(type == "tag_count") {
+            map.details.tag_count = output.toLongLong();
+        }
+        else if(type == "crc32") {
+            map.details.crc32 = output;
+        }
+
+        this->update_map(map);
+        if(--map.pending == 0) {
+            this->finish_map(map);
+        }
+    }
+
+    void MapsBrowser::finish_map(Map &map) {
+        this->maps_done++;
+        this->update_status();
+
+        // Only remember what we're sure of
+        if(!map.key.has_value() || map.failed) {
+            return;
+        }
+
+        auto *cache = this->main_window->get_map_info_cache();
+        if(map.details_queried) {
+            cache->set_details(*map.key, map.details);
+        }
+        if(map.protection_queried) {
+            cache->set_protection(*map.key, map.protection);
+        }
+    }
+
+    void MapsBrowser::update_map(const Map &map) {
+        if(map.invalid) {
+            map.items[Column::Engine]->setText("Invalid map");
+        }
+        else {
+            map.items[Column::Engine]->setText(map.details.engine);
+        }
+        map.items[Column::Scenario]->setText(map.details.scenario);
+        if(map.details.tag_count >= 0) {
+            map.items[Column::TagCount]->setData(Qt::DisplayRole, map.details.tag_count);
+        }
+        map.items[Column::Crc32]->setText(map.details.crc32);
+
+        switch(map.protection) {
+            case MapInfoCache::Protection::Protected:
+                map.items[Column::Protection]->setText("Yes");
+                break;
+            case MapInfoCache::Protection::Unprotected:
+                map.items[Column::Protection]->setText("No");
+                break;
+            default:
+                map.items[Column::Protection]->setText(QString());
+                break;
+        }
+    }
+
+    void MapsBrowser::update_status() {
+        if(this->maps_done < this->maps.size()) {
+            this->status->setText(QString("Reading maps... %1 of %2 done").arg(this->maps_done).arg(this->maps.size()));
+        }
+        else {
+            this->status->setText(QString("%1 map%2").arg(this->maps.size()).arg(this->maps.size() == 1 ? "" : "s"));
+            this->table->setSortingEnabled(true);
+        }
+    }
+}
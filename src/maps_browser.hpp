@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SIX_SHOOTER_MAPS_BROWSER_HPP
+#define SIX_SHOOTER_MAPS_BROWSER_HPP
+
+#include <QDialog>
+#include <deque>
+#include <optional>
+#include <vector>
+
+#include "map_info_cache.hpp"
+
+class QLabel;
+class QProcess;
+class QTableWidget;
+class QTableWidgetItem;
+class QThread;
+
+namespace SixShooter {
+    class MainWindow;
+
+    // Everything in the maps directory at a glance. Maps are listed right away and filled in as they're read and as
+    // invader-info gets through whatever can't be read directly, a few at a time; maps that were looked at before come
+    // straight from the cache.
+    class MapsBrowser : public QDialog {
+        Q_OBJECT
+        friend class MainWindow;
+
+    private:
+        enum Column {
+            Name,
+            Engine,
+            Scenario,
+            TagCount,
+            Protection,
+            Crc32,
+            Size,
+            ColumnCount
+        };
+
+        struct Map {
+            QString path;
+            std::optional<MapInfoCache::Key> key;
+            MapInfoCache::Details details;
+            MapInfoCache::Protection protection = MapInfoCache::Protection::Unknown;
+            bool invalid = false;
+
+            // What's still being looked up, and whether any of it failed (in which case nothing gets cached)
+            int pending = 0;
+            bool failed = false;
+            bool details_queried = false;
+            bool protection_queried = false;
+
+            QTableWidgetItem *items[Column::ColumnCount];
+        };
+
+        struct Query {
+            std::size_t map;
+            const char *type;
+        };
+
+        // What could be read from the map directly (everything but the CRC32)
+        struct NativeInfo {
+            MapInfoCache::Details details;
+            MapInfoCache::Protection protection;
+        };
+
+        MapsBrowser(const MainWindow *main_window);
+        ~MapsBrowser() override;
+        const MainWindow *main_window;
+
+        QTableWidget *table;
+        QLabel *status;
+
+        std::vector<Map> maps;
+        std::size_t maps_done = 0;
+
+        // Identifying and reading maps means going through a bit of each, so that's done on a thread of its own
+        QThread *key_thread = nullptr;
+
+        // invader-info runs, no more than one per core at a time
+        std::deque<Query> queries;
+        std::vector<QProcess *> processes;
+
+        void set_key(std::size_t map, const std::optional<MapInfoCache::Key> &key, const std::optional<NativeInfo> &native);
+        void run_queries();
+        void set_result(const Query &query, int exit_code, const QString &output);
+        void finish_map(Map &map);
+        void update_map(const Map &map);
+        void update_status();
+    };
+}
+
+#endif
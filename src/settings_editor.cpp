@@ -13,10 +13,13 @@
 #include <QMessageBox>
 #include <QTableWidget>
 #include <QHeaderView>
+#include <QSpinBox>
+#include <QCheckBox>
 
 #include "main_window.hpp"
 #include "settings_editor.hpp"
 #include "settings.hpp"
+#include "console_box.hpp"
 
 namespace SixShooter {
     class SettingsEditor::Finder : public QGroupBox {
@@ -98,6 +101,57 @@ namespace SixShooter {
         tags_box->setLayout(tags_box_layout);
         main_layout->addWidget(tags_box);
         
+        // Console output
+        {
+            SixShooterSettings settings;
+            
+            auto *console_box = new QGroupBox("Console output", this);
+            auto *console_layout = new QGridLayout(console_box);
+            
+            auto *scrollback_lines_label = new QLabel("Scrollback limit (lines):", console_box);
+            scrollback_lines_label->setSizePolicy(QSizePolicy::Policy::Fixed, QSizePolicy::Policy::Fixed);
+            console_layout->addWidget(scrollback_lines_label, 0, 0);
+            this->scrollback_lines = new QSpinBox(console_box);
+            this->scrollback_lines->setRange(0, 10000000);
+            this->scrollback_lines->setSingleStep(1000);
+            this->scrollback_lines->setSpecialValueText("Unlimited");
+            this->scrollback_lines->setValue(settings.value("console_scrollback_lines", ConsoleBox::DEFAULT_SCROLLBACK_LINES).toInt());
+            console_layout->addWidget(this->scrollback_lines, 0, 1);
+            
+            auto *scrollback_mib_label = new QLabel("Scrollback limit (MiB):", console_box);
+            scrollback_mib_label->setSizePolicy(QSizePolicy::Policy::Fixed, QSizePolicy::Policy::Fixed);
+            console_layout->addWidget(scrollback_mib_label, 1, 0);
+            this->scrollback_mib = new QSpinBox(console_box);
+            this->scrollback_mib->setRange(0, 4096);
+            this->scrollback_mib->setSpecialValueText("Unlimited");
+            this->scrollback_mib->setValue(static_cast<int>(settings.value("console_scrollback_bytes", ConsoleBox::DEFAULT_SCROLLBACK_BYTES).toLongLong() / (1024 * 1024)));
+            console_layout->addWidget(this->scrollback_mib, 1, 1);
+            
+            auto *log_to_disk_label = new QLabel("Keep full logs on disk:", console_box);
+            log_to_disk_label->setSizePolicy(QSizePolicy::Policy::Fixed, QSizePolicy::Policy::Fixed);
+            console_layout->addWidget(log_to_disk_label, 2, 0);
+            this->log_to_disk = new QCheckBox(console_box);
+            this->log_to_disk->setChecked(settings.value("console_log_to_disk", false).toBool());
+            console_layout->addWidget(this->log_to_disk, 2, 1);
+            
+            auto *virtualized_console_label = new QLabel("Fast console for huge logs (no word wrap):", console_box);
+            virtualized_console_label->setSizePolicy(QSizePolicy::Policy::Fixed, QSizePolicy::Policy::Fixed);
+            console_layout->addWidget(virtualized_console_label, 3, 0);
+            this->virtualized_console = new QCheckBox(console_box);
+            this->virtualized_console->setChecked(settings.value("console_virtualized", false).toBool());
+            console_layout->addWidget(this->virtualized_console, 3, 1);
+            
+            auto *unified_console_label = new QLabel("Combine output and errors with timestamps:", console_box);
+            unified_console_label->setSizePolicy(QSizePolicy::Policy::Fixed, QSizePolicy::Policy::Fixed);
+            console_layout->addWidget(unified_console_label, 4, 0);
+            this->unified_console = new QCheckBox(console_box);
+            this->unified_console->setChecked(settings.value("console_unified", false).toBool());
+            console_layout->addWidget(this->unified_console, 4, 1);
+            
+            console_box->setLayout(console_layout);
+            main_layout->addWidget(console_box);
+        }
+        
         auto *qdbb = new QDialogButtonBox(QDialogButtonBox::Save | QDialogButtonBox::Cancel, this);
         main_layout->addWidget(qdbb);
         
@@ -226,6 +280,11 @@ namespace SixShooter {
         settings.setValue("maps_path", map_path);
         settings.setValue("data_path", data_path);
         settings.setValue("tags_directories", tags_path);
+        settings.setValue("console_scrollback_lines", this->scrollback_lines->value());
+        settings.setValue("console_scrollback_bytes", static_cast<qint64>(this->scrollback_mib->value()) * 1024 * 1024);
+        settings.setValue("console_log_to_disk", this->log_to_disk->isChecked());
+        settings.setValue("console_virtualized", this->virtualized_console->isChecked());
+        settings.setValue("console_unified", this->unified_console->isChecked());
         
         QDialog::accept();
     }
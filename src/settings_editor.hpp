@@ -9,6 +9,8 @@
 
 class QLineEdit;
 class QTableWidget;
+class QSpinBox;
+class QCheckBox;
 
 namespace SixShooter {
     class MainWindow;
@@ -29,6 +31,12 @@ namespace SixShooter {
         QTableWidget *tags;
         std::vector<std::filesystem::path> tags_paths;
         
+        QSpinBox *scrollback_lines;
+        QSpinBox *scrollback_mib;
+        QCheckBox *log_to_disk;
+        QCheckBox *virtualized_console;
+        QCheckBox *unified_console;
+        
         void save_settings();
         void reject() override;
         void accept() override;
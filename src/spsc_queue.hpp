@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SIX_SHOOTER_SPSC_QUEUE_HPP
+#define SIX_SHOOTER_SPSC_QUEUE_HPP
+
+#include <atomic>
+#include <utility>
+
+namespace SixShooter {
+    // Unbounded lock-free queue for exactly one producer thread and one consumer thread. The producer never waits on the
+    // consumer, so a slow consumer only costs memory.
+    template<typename T> class SpscQueue {
+    public:
+        SpscQueue() : head(new Node()), tail(this->head) {}
+
+        ~SpscQueue() {
+            while(this->head != nullptr) {
+                auto *next = this->head->next.load(std::memory_order_relaxed);
+                delete this->head;
+                this->head = next;
+            }
+        }
+
+        SpscQueue(const SpscQueue &) = delete;
+        SpscQueue &operator=(const SpscQueue &) = delete;
+
+        // Producer only
+        void push(T value) {
+            auto *node = new Node();
+            node->value = std::move(value);
+            this->tail->next.store(node, std::memory_order_release);
+            this->tail = node;
+        }
+
+        // Consumer only
+        bool pop(T &value) {
+            auto *next = this->head->next.load(std::memory_order_acquire);
+            if(next == nullptr) {
+                return false;
+            }
+            value = std::move(next->value);
+            delete this->head;
+            this->head = next;
+            return true;
+        }
+
+    private:
+        struct Node {
+            T value;
+            std::atomic<Node *> next { nullptr };
+        };
+
+        // The consumer owns head (a dummy node whose value was already taken), the producer owns tail
+        Node *head;
+        Node *tail;
+    };
+}
+
+#endif
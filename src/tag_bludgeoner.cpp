@@ -18,6 +18,7 @@
 #include "console_box.hpp"
 #include "main_window.hpp"
 #include "tag_bludgeoner.hpp"
+#include "tag_index_service.hpp"
 
 namespace SixShooter {
     struct BludgeonCommand {
@@ -68,18 +69,25 @@ namespace SixShooter {
             options_main_layout->addWidget(tags_directory_label, 0, 0);
             options_main_layout->addWidget(this->tags, 0, 1);
 
+            // How much there is to bludgeon, kept current as tags get added or removed
+            this->tag_count = new QLabel(options_widget);
+            options_main_layout->addWidget(this->tag_count, 1, 1);
+            connect(this->tags, &QComboBox::currentTextChanged, this, &TagBludgeoner::update_tag_count);
+            connect(this->main_window->get_tag_index(), &TagIndexService::updated, this, &TagBludgeoner::update_tag_count);
+            this->update_tag_count();
+
             // Add options here
-            options_main_layout->addWidget(new QLabel("Fix up tags:", options_widget), 1, 0);
-            options_main_layout->addWidget(this->fix_up_tags = new QCheckBox(options_widget), 1, 1);
+            options_main_layout->addWidget(new QLabel("Fix up tags:", options_widget), 2, 0);
+            options_main_layout->addWidget(this->fix_up_tags = new QCheckBox(options_widget), 2, 1);
 
-            options_main_layout->addWidget(new QLabel("Clean up tags:", options_widget), 2, 0);
-            options_main_layout->addWidget(this->clean_up_tags = new QCheckBox(options_widget), 2, 1);
+            options_main_layout->addWidget(new QLabel("Clean up tags:", options_widget), 3, 0);
+            options_main_layout->addWidget(this->clean_up_tags = new QCheckBox(options_widget), 3, 1);
 
-            options_main_layout->addWidget(new QLabel("Optimize shader references:", options_widget), 3, 0);
-            options_main_layout->addWidget(this->optimize_shader_references = new QCheckBox(options_widget), 3, 1);
+            options_main_layout->addWidget(new QLabel("Optimize shader references:", options_widget), 4, 0);
+            options_main_layout->addWidget(this->optimize_shader_references = new QCheckBox(options_widget), 4, 1);
 
-            options_main_layout->addWidget(new QLabel("Refactor model references:", options_widget), 4, 0);
-            options_main_layout->addWidget(this->refactor_model_references = new QComboBox(options_widget), 4, 1);
+            options_main_layout->addWidget(new QLabel("Refactor model references:", options_widget), 5, 0);
+            options_main_layout->addWidget(this->refactor_model_references = new QComboBox(options_widget), 5, 1);
             this->refactor_model_references->addItem("Do nothing");
             this->refactor_model_references->addItem("Change model references to gbxmodel (base HEK tags need it)", static_cast<uint>(TagBludgeoner::Step::RefactorModelToGbxmodel));
             this->refactor_model_references->addItem("Change gbxmodel references to model (Xbox porting)", static_cast<uint>(TagBludgeoner::Step::RefactorGbxmodelToModel));
@@ -115,6 +123,17 @@ namespace SixShooter {
         }
     }
 
+    void TagBludgeoner::update_tag_count() {
+        auto *index = this->main_window->get_tag_index();
+        if(!index->is_ready()) {
+            this->tag_count->setText("Counting tags...");
+            return;
+        }
+
+        auto count = index->get_tag_count(this->tags->currentText().toStdString());
+        this->tag_count->setText(QString("%1 file%2").arg(count).arg(count == 1 ? "" : "s"));
+    }
+
     void TagBludgeoner::bludgeon_tags() {
         if(this->fix_up_tags->isChecked()) {
             this->steps.emplace_back(Step::FixUpTags);
@@ -168,17 +187,17 @@ namespace SixShooter {
         }
 
         // Invoke
-        this->process = new QProcess(this);
+        this->process = this->create_process();
         this->attach_to_process(this->process);
         connect(this->process, &QProcess::stateChanged, this, &TagBludgeoner::set_ready);
         this->process->setProgram(this->main_window->executable_path(more_arguments.command).string().c_str());
         this->process->setArguments(arguments);
-        this->process->start();
+        this->start_process(this->process);
     }
 
     void TagBludgeoner::reject() {
         if(this->process != nullptr) {
-            if(this->process->state() == QProcess::ProcessState::Running) {
+            if(this->process_is_running(this->process)) {
                 QMessageBox qmb;
                 qmb.setWindowTitle("Tag bludgeoning in progress");
                 qmb.setText("Are you sure you want to stop bludgeoning tags?\n\nAborting the bludgeon process may leave your tags directory in an inconsistent or potentially corrupted state.");
@@ -187,7 +206,7 @@ namespace SixShooter {
                 if(qmb.exec() == QMessageBox::StandardButton::Cancel) {
                     return;
                 }
-                this->process->kill();
+                this->kill_process(this->process);
                 this->cleanup_process();
             }
         }
@@ -196,8 +215,8 @@ namespace SixShooter {
 
     void TagBludgeoner::cleanup_process() {
         if(this->process != nullptr) {
-            this->process->waitForFinished(-1);
-            this->process->deleteLater();
+            this->wait_for_process(this->process);
+            this->destroy_process(this->process);
             this->process = nullptr;
         }
     }
@@ -15,6 +15,7 @@
 class QComboBox;
 class QPushButton;
 class QCheckBox;
+class QLabel;
 
 namespace SixShooter {
     class MainWindow;
@@ -43,6 +44,7 @@ namespace SixShooter {
         QString tags_dir;
 
         QComboBox *tags;
+        QLabel *tag_count;
         QComboBox *refactor_model_references;
         QPushButton *bludgeon_button;
         QProcess *process = nullptr;
@@ -54,6 +56,7 @@ namespace SixShooter {
         void reject() override;
 
         void set_ready(QProcess::ProcessState);
+        void update_tag_count();
         void bludgeon_tags();
 
         void next_in_queue();
@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <QThread>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+#include "tag_directory_walker.hpp"
+
+namespace SixShooter {
+    std::size_t TagDirectoryWalker::prefix_length(const std::filesystem::path &tags_directory) {
+        auto &native = tags_directory.native();
+        auto prefix_length = native.size();
+        if(!native.empty() && native.back() != std::filesystem::path::preferred_separator && native.back() != '/') {
+            prefix_length++;
+        }
+        return prefix_length;
+    }
+
+    QString TagDirectoryWalker::relative_path(const std::filesystem::path &path, std::size_t prefix_length) {
+        auto &native = path.native();
+        if(native.size() <= prefix_length) {
+            return QString();
+        }
+
+        // Paths are UTF-16 on Windows and UTF-8 everywhere else
+        auto *relative = native.data() + prefix_length;
+        auto length = static_cast<qsizetype>(native.size() - prefix_length);
+        if constexpr(std::is_same_v<std::filesystem::path::value_type, wchar_t>) {
+            return QString::fromWCharArray(reinterpret_cast<const wchar_t *>(relative), length);
+        }
+        else {
+            return QString::fromUtf8(reinterpret_cast<const char *>(relative), length);
+        }
+    }
+
+    unsigned int TagDirectoryWalker::default_thread_count() {
+        return static_cast<unsigned int>(std::max(QThread::idealThreadCount(), 1));
+    }
+
+    void TagDirectoryWalker::walk(const std::vector<std::filesystem::path> &tags_directories, const Visitor &visitor, unsigned int thread_count) {
+        if(thread_count == 0) {
+            thread_count = default_thread_count();
+        }
+
+        struct Directory {
+            std::filesystem::path path;
+            std::size_t tags_directory;
+        };
+
+        struct WorkQueue {
+            std::mutex mutex;
+            std::deque<Directory> directories;
+        };
+
+        std::vector<WorkQueue> queues(thread_count);
+
+        // Directories queued or being visited; once this hits 0, everyone's done
+        std::atomic<std::size_t> pending { 0 };
+
+        for(std::size_t i = 0; i < tags_directories.size(); i++) {
+            pending++;
+            queues[i % thread_count].directories.emplace_back(Directory { tags_directories[i], i });
+        }
+
+        // Threads with nothing to do sleep until more directories are queued or everyone's done. The count goes up
+        // (under the mutex) each time either happens, so a thread that looked just before doesn't miss it.
+        std::mutex idle_mutex;
+        std::condition_variable idle;
+        std::atomic<std::uint64_t> changes { 0 };
+        auto wake_up = [&]() {
+            {
+                std::scoped_lock lock(idle_mutex);
+                changes++;
+            }
+            idle.notify_all();
+        };
+
+        auto work = [&](unsigned int self) {
+            auto &own = queues[self];
+            std::vector<std::filesystem::path> subdirectories;
+
+            while(pending.load() > 0) {
+                Directory directory;
+                bool have_directory = false;
+                auto changes_seen = changes.load();
+
+                // Take the newest directory from our own queue (it's probably still cached), or the oldest from someone
+                // else's (it probably has the most left under it)
+                {
+                    std::scoped_lock lock(own.mutex);
+                    if(!own.directories.empty()) {
+                        directory = std::move(own.directories.back());
+                        own.directories.pop_back();
+                        have_directory = true;
+                    }
+                }
+
+                for(unsigned int other = 1; !have_directory && other < thread_count; other++) {
+                    auto &victim = queues[(self + other) % thread_count];
+                    std::scoped_lock lock(victim.mutex);
+                    if(!victim.directories.empty()) {
+                        directory = std::move(victim.directories.front());
+                        victim.directories.pop_front();
+                        have_directory = true;
+                    }
+                }
+
+                if(!have_directory) {
+                    std::unique_lock lock(idle_mutex);
+                    idle.wait(lock, [&]() { return changes.load() != changes_seen || pending.load() == 0; });
+                    continue;
+                }
+
+                subdirectories.clear();
+                visitor(directory.path, directory.tags_directory, self, subdirectories);
+
+                if(!subdirectories.empty()) {
+                    pending += subdirectories.size();
+                    {
+                        std::scoped_lock lock(own.mutex);
+                        for(auto &subdirectory : subdirectories) {
+                            own.directories.emplace_back(Directory { std::move(subdirectory), directory.tags_directory });
+                        }
+                    }
+                    wake_up();
+                }
+
+                if(--pending == 0) {
+                    wake_up();
+                }
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for(unsigned int i = 1; i < thread_count; i++) {
+            threads.emplace_back(work, i);
+        }
+        work(0);
+        for(auto &thread : threads) {
+            thread.join();
+        }
+    }
+}
@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SIX_SHOOTER_TAG_DIRECTORY_WALKER_HPP
+#define SIX_SHOOTER_TAG_DIRECTORY_WALKER_HPP
+
+#include <QStringList>
+#include <filesystem>
+#include <functional>
+#include <vector>
+
+namespace SixShooter {
+    // Walks tags directories using several threads. Each thread works through its own queue of directories and
+    // steals from the others once it runs out.
+    class TagDirectoryWalker {
+    public:
+        // Called for each directory on whichever thread picked it up (0 to thread count - 1). Fill in the
+        // subdirectories to walk into next.
+        using Visitor = std::function<void(const std::filesystem::path &directory, std::size_t tags_directory, unsigned int thread, std::vector<std::filesystem::path> &subdirectories)>;
+
+        // Visit every directory under the given tags directories. Blocks until done. A thread count of 0 uses one per
+        // core.
+        static void walk(const std::vector<std::filesystem::path> &tags_directories, const Visitor &visitor, unsigned int thread_count = 0);
+
+        // Number of threads walk() uses for a thread count of 0
+        static unsigned int default_thread_count();
+
+        // Path relative to the tags directory whose path is prefix_length characters long (see prefix_length())
+        static QString relative_path(const std::filesystem::path &path, std::size_t prefix_length);
+
+        // Length of a tags directory's path including the separator after it
+        static std::size_t prefix_length(const std::filesystem::path &tags_directory);
+    };
+}
+
+#endif
@@ -0,0 +1,332 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <QThread>
+#include <QTimer>
+#include <QSocketNotifier>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "tag_index_service.hpp"
+
+namespace SixShooter {
+    TagIndexService::TagIndexService(QObject *parent) : QObject(parent) {
+        this->thread = new QThread(this);
+        this->worker = new QObject();
+        this->worker->moveToThread(this->thread);
+        this->thread->start();
+
+        QMetaObject::invokeMethod(this->worker, [this]() {
+            this->start_worker();
+        }, Qt::ConnectionType::QueuedConnection);
+    }
+
+    TagIndexService::~TagIndexService() {
+        QMetaObject::invokeMethod(this->worker, [this]() {
+            this->stop_worker();
+            delete this->worker;
+        }, Qt::ConnectionType::BlockingQueuedConnection);
+
+        this->thread->quit();
+        this->thread->wait();
+    }
+
+    void TagIndexService::set_directories(const std::vector<std::filesystem::path> &tags_directories, const std::filesystem::path &data_directory) {
+        std::vector<Root> roots;
+        for(auto &i : tags_directories) {
+            roots.emplace_back(Root { i, false, nullptr });
+        }
+        if(!data_directory.empty()) {
+            roots.emplace_back(Root { data_directory, true, nullptr });
+        }
+
+        std::uint64_t generation;
+        {
+            std::scoped_lock lock(this->published_mutex);
+            generation = ++this->generation;
+            this->ready = false;
+        }
+
+        QMetaObject::invokeMethod(this->worker, [this, roots = std::move(roots), generation]() mutable {
+            this->reset_roots(std::move(roots), generation);
+        }, Qt::ConnectionType::QueuedConnection);
+    }
+
+    bool TagIndexService::is_ready() const {
+        std::scoped_lock lock(this->published_mutex);
+        return this->ready;
+    }
+
+    static QStringList find_in(const std::vector<std::shared_ptr<const std::vector<TagInventory::Tag>>> &lists, const QString &extension) {
+        QStringList list;
+        QSet<QString> seen;
+
+        for(auto &tags : lists) {
+            for(auto &tag : *tags) {
+                if(tag.path.endsWith(extension) && !seen.contains(tag.path)) {
+                    seen.insert(tag.path);
+                    list << tag.path;
+                }
+            }
+        }
+
+        return list;
+    }
+
+    QStringList TagIndexService::find_tags(const QString &extension) const {
+        // Only hold the lock long enough to grab the lists; they never change once published
+        std::vector<TagList> lists;
+        {
+            std::scoped_lock lock(this->published_mutex);
+            for(auto &root : this->published) {
+                if(!root.data && root.tags) {
+                    lists.emplace_back(root.tags);
+                }
+            }
+        }
+        return find_in(lists, extension);
+    }
+
+    QStringList TagIndexService::find_data(const QString &extension) const {
+        std::vector<TagList> lists;
+        {
+            std::scoped_lock lock(this->published_mutex);
+            for(auto &root : this->published) {
+                if(root.data && root.tags) {
+                    lists.emplace_back(root.tags);
+                }
+            }
+        }
+        return find_in(lists, extension);
+    }
+
+    std::size_t TagIndexService::get_tag_count(const std::filesystem::path &tags_directory) const {
+        std::scoped_lock lock(this->published_mutex);
+        for(auto &root : this->published) {
+            if(!root.data && root.tags && root.path == tags_directory) {
+                return root.tags->size();
+            }
+        }
+        return 0;
+    }
+
+    void TagIndexService::start_worker() {
+        this->coalesce_timer = new QTimer(this->worker);
+        this->coalesce_timer->setSingleShot(true);
+        this->coalesce_timer->setInterval(COALESCE_MS);
+        connect(this->coalesce_timer, &QTimer::timeout, this->worker, [this]() {
+            this->update_dirty_roots();
+        });
+
+        #ifdef __linux__
+        this->inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if(this->inotify_fd >= 0) {
+            this->inotify_notifier = new QSocketNotifier(this->inotify_fd, QSocketNotifier::Type::Read, this->worker);
+            connect(this->inotify_notifier, &QSocketNotifier::activated, this->worker, [this]() {
+                this->read_events();
+            });
+            return;
+        }
+        std::fprintf(stderr, "Failed to start watching for tag changes: %s\n", std::strerror(errno));
+        #endif
+
+        // No way to be told about changes, so check every so often instead
+        this->start_polling();
+    }
+
+    void TagIndexService::start_polling() {
+        if(this->poll_timer == nullptr) {
+            this->poll_timer = new QTimer(this->worker);
+            this->poll_timer->setInterval(POLL_INTERVAL_MS);
+            connect(this->poll_timer, &QTimer::timeout, this->worker, [this]() {
+                // Without inotify, everything; otherwise only what couldn't be watched
+                bool any = false;
+                for(std::size_t i = 0; i < this->roots.size(); i++) {
+                    if(this->inotify_fd < 0 || this->unwatched[i]) {
+                        this->dirty[i] = true;
+                        any = true;
+                    }
+                }
+                if(any) {
+                    this->update_dirty_roots();
+                }
+            });
+        }
+        if(!this->poll_timer->isActive()) {
+            this->poll_timer->start();
+        }
+    }
+
+    void TagIndexService::stop_worker() {
+        this->unwatch_all();
+
+        #ifdef __linux__
+        if(this->inotify_fd >= 0) {
+            delete this->inotify_notifier;
+            this->inotify_notifier = nullptr;
+            close(this->inotify_fd);
+            this->inotify_fd = -1;
+        }
+        #endif
+    }
+
+    void TagIndexService::reset_roots(std::vector<Root> roots, std::uint64_t generation) {
+        this->unwatch_all();
+        this->coalesce_timer->stop();
+        this->roots = std::move(roots);
+        this->roots_generation = generation;
+        this->dirty.assign(this->roots.size(), true);
+        this->unwatched.assign(this->roots.size(), false);
+
+        // Only needed for directories that turn out not to be watchable
+        if(this->inotify_fd >= 0 && this->poll_timer != nullptr) {
+            this->poll_timer->stop();
+        }
+        this->update_dirty_roots();
+    }
+
+    void TagIndexService::update_dirty_roots() {
+        for(std::size_t i = 0; i < this->roots.size(); i++) {
+            if(!this->dirty[i]) {
+                continue;
+            }
+            this->dirty[i] = false;
+
+            // Only directories that changed since the last time get read again
+            TagInventory inventory(this->roots[i].path);
+            inventory.update();
+            this->roots[i].tags = std::make_shared<const std::vector<TagInventory::Tag>>(inventory.get_tags());
+            this->watch(i, inventory);
+        }
+
+        this->publish();
+    }
+
+    void TagIndexService::publish() {
+        {
+            std::scoped_lock lock(this->published_mutex);
+
+            // Directories were changed again since; wait for those
+            if(this->roots_generation != this->generation) {
+                return;
+            }
+
+            this->published = this->roots;
+            this->ready = true;
+        }
+
+        emit this->updated();
+    }
+
+    void TagIndexService::watch(std::size_t root, const TagInventory &inventory) {
+        #ifdef __linux__
+        // Already being checked every so often instead
+        if(this->inotify_fd < 0 || this->unwatched[root]) {
+            return;
+        }
+
+        auto &root_path = this->roots[root].path;
+        for(auto &directory : inventory.get_directories()) {
+            auto path = directory.isEmpty() ? root_path : root_path / directory.toStdU16String();
+            auto key = QString::fromStdU16String(path.u16string());
+            if(this->watched_paths.contains(key)) {
+                continue;
+            }
+
+            int wd = inotify_add_watch(this->inotify_fd, path.c_str(), IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR);
+            if(wd < 0) {
+                // Probably out of watches (see fs.inotify.max_user_watches), so check this one every so often instead
+                if(errno == ENOSPC) {
+                    std::fprintf(stderr, "Ran out of inotify watches while watching %s; checking it for changes every %d seconds instead\n", root_path.string().c_str(), POLL_INTERVAL_MS / 1000);
+                    this->unwatched[root] = true;
+                    this->start_polling();
+                    return;
+                }
+                continue;
+            }
+
+            // Same directory under a different path (it was moved)
+            auto existing = this->watches.constFind(wd);
+            if(existing != this->watches.constEnd()) {
+                this->watched_paths.remove(existing->path);
+            }
+
+            this->watches.insert(wd, Watch { root, key });
+            this->watched_paths.insert(key);
+        }
+        #else
+        Q_UNUSED(root);
+        Q_UNUSED(inventory);
+        #endif
+    }
+
+    void TagIndexService::unwatch_all() {
+        #ifdef __linux__
+        for(auto i = this->watches.cbegin(); i != this->watches.cend(); i++) {
+            inotify_rm_watch(this->inotify_fd, i.key());
+        }
+        #endif
+
+        this->watches.clear();
+        this->watched_paths.clear();
+    }
+
+    void TagIndexService::read_events() {
+        #ifdef __linux__
+        alignas(struct inotify_event) char buffer[16 * 1024];
+
+        while(true) {
+            auto length = read(this->inotify_fd, buffer, sizeof(buffer));
+            if(length <= 0) {
+                break;
+            }
+
+            for(char *i = buffer; i < buffer + length;) {
+                auto *event = reinterpret_cast<const struct inotify_event *>(i);
+                i += sizeof(struct inotify_event) + event->len;
+
+                // Too much happened at once to know what; just check everything
+                if(event->mask & IN_Q_OVERFLOW) {
+                    this->dirty.assign(this->roots.size(), true);
+                    continue;
+                }
+
+                auto watch = this->watches.find(event->wd);
+                if(watch == this->watches.end()) {
+                    continue;
+                }
+
+                this->dirty[watch->root] = true;
+
+                // It'll be watched again under its new path on the next update
+                if(event->mask & IN_MOVE_SELF) {
+                    inotify_rm_watch(this->inotify_fd, event->wd);
+                }
+
+                if(event->mask & IN_IGNORED) {
+                    this->watched_paths.remove(watch->path);
+                    this->watches.erase(watch);
+                }
+            }
+        }
+
+        this->schedule_update();
+        #endif
+    }
+
+    void TagIndexService::schedule_update() {
+        // Keep pushing it back while changes keep coming in, up to a point
+        if(!this->coalesce_timer->isActive()) {
+            this->first_change.start();
+            this->coalesce_timer->start();
+        }
+        else if(this->first_change.elapsed() < MAX_COALESCE_MS) {
+            this->coalesce_timer->start();
+        }
+    }
+}
@@ -0,0 +1,114 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SIX_SHOOTER_TAG_INDEX_SERVICE_HPP
+#define SIX_SHOOTER_TAG_INDEX_SERVICE_HPP
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "tag_inventory.hpp"
+
+class QThread;
+class QTimer;
+class QSocketNotifier;
+
+namespace SixShooter {
+    // Keeps an in-memory list of everything in the tags directories and the data directory, and keeps it current while
+    // other tools change them. Changes are picked up with inotify on Linux (elsewhere, by checking every few seconds),
+    // gathered up for a moment, and then only the directories that changed are read again (see TagInventory).
+    //
+    // Scanning and watching happen on a thread of its own; lookups can be done from any thread.
+    class TagIndexService : public QObject {
+        Q_OBJECT
+    public:
+        // Wait this long after the last change before updating, but never more than MAX_COALESCE_MS after the first
+        static constexpr int COALESCE_MS = 250;
+        static constexpr qint64 MAX_COALESCE_MS = 2000;
+
+        // Where inotify isn't available (or runs out of watches)
+        static constexpr int POLL_INTERVAL_MS = 5000;
+
+        TagIndexService(QObject *parent = nullptr);
+        ~TagIndexService() override;
+
+        // Start indexing and watching these (GUI thread)
+        void set_directories(const std::vector<std::filesystem::path> &tags_directories, const std::filesystem::path &data_directory);
+
+        // Whether everything was indexed at least once since the directories were set
+        bool is_ready() const;
+
+        // Relative paths of every tag ending in the given extension (e.g. ".scenario"). Tags in more than one tags
+        // directory are only listed once. Not sorted.
+        QStringList find_tags(const QString &extension) const;
+
+        // Same, but for the data directory
+        QStringList find_data(const QString &extension) const;
+
+        // Number of files in one of the tags directories, or 0 if it isn't indexed (yet)
+        std::size_t get_tag_count(const std::filesystem::path &tags_directory) const;
+
+    signals:
+        // Emitted on the index's own thread whenever the index changed, so connect with a receiver (or a queued
+        // connection) to handle it on the GUI thread. Connect before checking is_ready() so it can't be missed.
+        void updated();
+
+    private:
+        using TagList = std::shared_ptr<const std::vector<TagInventory::Tag>>;
+
+        struct Root {
+            std::filesystem::path path;
+            bool data;
+            TagList tags;
+        };
+
+        // Worker thread only
+        void start_worker();
+        void stop_worker();
+        void reset_roots(std::vector<Root> roots, std::uint64_t generation);
+        void update_dirty_roots();
+        void watch(std::size_t root, const TagInventory &inventory);
+        void unwatch_all();
+        void read_events();
+        void schedule_update();
+        void start_polling();
+        void publish();
+
+        QThread *thread;
+        QObject *worker;
+
+        // Worker thread state
+        std::vector<Root> roots;
+        std::uint64_t roots_generation = 0;
+        std::vector<bool> dirty;
+
+        // Roots that couldn't be watched in full, so they get polled instead
+        std::vector<bool> unwatched;
+        QTimer *coalesce_timer = nullptr;
+        QTimer *poll_timer = nullptr;
+        QElapsedTimer first_change;
+        int inotify_fd = -1;
+        QSocketNotifier *inotify_notifier = nullptr;
+        struct Watch {
+            std::size_t root;
+            QString path;
+        };
+        QHash<int, Watch> watches;
+        QSet<QString> watched_paths;
+
+        // What lookups see; the generation goes up every time the directories are set so stale results are never shown
+        mutable std::mutex published_mutex;
+        std::vector<Root> published;
+        std::uint64_t generation = 0;
+        bool ready = false;
+    };
+}
+
+#endif
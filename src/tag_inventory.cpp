@@ -0,0 +1,295 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "tag_directory_walker.hpp"
+#include "tag_inventory.hpp"
+
+namespace SixShooter {
+    // Inventory files are a header followed by each directory:
+    //
+    //     i64 modified, u32 path length, u32 file count, u32 subdirectory count, path
+    //     per file: i64 size, i64 modified, u32 name length, name
+    //     per subdirectory: u32 name length, name
+    //
+    // Strings are UTF-16 without a terminator; everything is native byte order since it never leaves this machine.
+    struct InventoryHeader {
+        char magic[4];
+        std::uint32_t version;
+        std::uint32_t directory_count;
+        std::uint32_t reserved;
+    };
+
+    static constexpr char INVENTORY_MAGIC[4] = { 'S', 'S', 'T', 'I' };
+    static constexpr std::uint32_t INVENTORY_VERSION = 1;
+
+    static qint64 modified_time(std::filesystem::file_time_type time) noexcept {
+        return static_cast<qint64>(time.time_since_epoch().count());
+    }
+
+    // Bounds-checked reads out of a mapped inventory
+    class InventoryReader {
+    public:
+        InventoryReader(const uchar *data, qint64 size) : data(data), size(size) {}
+
+        template<typename T> bool read(T &value) noexcept {
+            if(this->size - this->offset < static_cast<qint64>(sizeof(value))) {
+                return false;
+            }
+            std::memcpy(&value, this->data + this->offset, sizeof(value));
+            this->offset += sizeof(value);
+            return true;
+        }
+
+        bool read_string(QString &string, std::uint32_t length) {
+            auto bytes = static_cast<qint64>(length) * static_cast<qint64>(sizeof(char16_t));
+            if(this->size - this->offset < bytes) {
+                return false;
+            }
+            string = QString(static_cast<qsizetype>(length), Qt::Uninitialized);
+            std::memcpy(string.data(), this->data + this->offset, bytes);
+            this->offset += bytes;
+            return true;
+        }
+
+        bool read_string(QString &string) {
+            std::uint32_t length;
+            return this->read(length) && this->read_string(string, length);
+        }
+
+    private:
+        const uchar *data;
+        qint64 size;
+        qint64 offset = 0;
+    };
+
+    template<typename T> static void write_value(QByteArray &data, const T &value) {
+        data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+    }
+
+    static void write_string(QByteArray &data, const QString &string) {
+        data.append(reinterpret_cast<const char *>(string.utf16()), string.size() * sizeof(char16_t));
+    }
+
+    QStringView TagInventory::Tag::tag_class() const noexcept {
+        auto dot = this->path.lastIndexOf(u'.');
+        if(dot < 0 || dot < this->path.lastIndexOf(QChar(std::filesystem::path::preferred_separator))) {
+            return QStringView();
+        }
+        return QStringView(this->path).mid(dot + 1);
+    }
+
+    TagInventory::TagInventory(const std::filesystem::path &tags_directory) : tags_directory(tags_directory) {}
+
+    QString TagInventory::get_cache_path() const {
+        std::error_code error;
+        auto absolute = std::filesystem::absolute(this->tags_directory, error);
+        auto key = QCryptographicHash::hash(QString::fromStdU16String((error ? this->tags_directory : absolute).u16string()).toUtf8(), QCryptographicHash::Algorithm::Sha1).toHex();
+        return QDir(QStandardPaths::writableLocation(QStandardPaths::StandardLocation::AppDataLocation)).filePath("inventory/" + QString::fromLatin1(key) + ".bin");
+    }
+
+    bool TagInventory::load(DirectoryMap &directories) const {
+        QFile file(this->get_cache_path());
+        if(!file.open(QIODevice::OpenModeFlag::ReadOnly) || file.size() < static_cast<qint64>(sizeof(InventoryHeader))) {
+            return false;
+        }
+
+        auto *data = file.map(0, file.size());
+        if(data == nullptr) {
+            return false;
+        }
+
+        InventoryReader reader(data, file.size());
+        InventoryHeader header;
+        reader.read(header);
+        if(std::memcmp(header.magic, INVENTORY_MAGIC, sizeof(header.magic)) != 0 || header.version != INVENTORY_VERSION) {
+            return false;
+        }
+
+        directories.reserve(header.directory_count);
+
+        for(std::uint32_t d = 0; d < header.directory_count; d++) {
+            Directory directory;
+            QString path;
+            std::uint32_t path_length, file_count, subdirectory_count;
+            if(!reader.read(directory.modified) || !reader.read(path_length) || !reader.read(file_count) || !reader.read(subdirectory_count) || !reader.read_string(path, path_length)) {
+                directories.clear();
+                return false;
+            }
+
+            // Don't trust counts from a damaged file for reserving memory
+            directory.files.reserve(std::min(file_count, 65536U));
+            for(std::uint32_t f = 0; f < file_count; f++) {
+                File tag_file;
+                if(!reader.read(tag_file.size) || !reader.read(tag_file.modified) || !reader.read_string(tag_file.name)) {
+                    directories.clear();
+                    return false;
+                }
+                directory.files.emplace_back(std::move(tag_file));
+            }
+
+            directory.subdirectories.reserve(std::min(subdirectory_count, 65536U));
+            for(std::uint32_t s = 0; s < subdirectory_count; s++) {
+                QString name;
+                if(!reader.read_string(name)) {
+                    directories.clear();
+                    return false;
+                }
+                directory.subdirectories.emplace_back(std::move(name));
+            }
+
+            directories.insert(path, std::move(directory));
+        }
+
+        return true;
+    }
+
+    void TagInventory::save(const DirectoryMap &directories) const {
+        QByteArray data;
+
+        InventoryHeader header = {};
+        std::memcpy(header.magic, INVENTORY_MAGIC, sizeof(header.magic));
+        header.version = INVENTORY_VERSION;
+        header.directory_count = static_cast<std::uint32_t>(directories.size());
+        write_value(data, header);
+
+        for(auto i = directories.cbegin(); i != directories.cend(); i++) {
+            auto &directory = i.value();
+            write_value(data, directory.modified);
+            write_value(data, static_cast<std::uint32_t>(i.key().size()));
+            write_value(data, static_cast<std::uint32_t>(directory.files.size()));
+            write_value(data, static_cast<std::uint32_t>(directory.subdirectories.size()));
+            write_string(data, i.key());
+
+            for(auto &file : directory.files) {
+                write_value(data, file.size);
+                write_value(data, file.modified);
+                write_value(data, static_cast<std::uint32_t>(file.name.size()));
+                write_string(data, file.name);
+            }
+
+            for(auto &subdirectory : directory.subdirectories) {
+                write_value(data, static_cast<std::uint32_t>(subdirectory.size()));
+                write_string(data, subdirectory);
+            }
+        }
+
+        // Write to a temporary file first so a crash can't leave a half-written inventory
+        auto path = this->get_cache_path();
+        QDir().mkpath(QFileInfo(path).absolutePath());
+        QSaveFile file(path);
+        if(!file.open(QIODevice::OpenModeFlag::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+            std::fprintf(stderr, "Failed to write %s\n", path.toLocal8Bit().data());
+        }
+    }
+
+    void TagInventory::update(unsigned int thread_count) {
+        if(thread_count == 0) {
+            thread_count = TagDirectoryWalker::default_thread_count();
+        }
+
+        DirectoryMap cached;
+        this->load(cached);
+
+        struct Visited {
+            QString path;
+            Directory directory;
+            bool rescanned;
+        };
+
+        auto prefix_length = TagDirectoryWalker::prefix_length(this->tags_directory);
+        std::vector<std::vector<Visited>> visited(thread_count);
+
+        // Only reading from the cache here, so all threads can share it
+        const auto &cache = cached;
+
+        TagDirectoryWalker::walk({ this->tags_directory }, [&](const std::filesystem::path &path, std::size_t, unsigned int thread, std::vector<std::filesystem::path> &subdirectories) {
+            Visited result;
+            result.path = TagDirectoryWalker::relative_path(path, prefix_length);
+
+            std::error_code error;
+            auto modified = std::filesystem::last_write_time(path, error);
+            if(error) {
+                return;
+            }
+            result.directory.modified = modified_time(modified);
+
+            // Nothing was added or removed here since last time
+            auto cached_directory = cache.constFind(result.path);
+            if(cached_directory != cache.constEnd() && cached_directory->modified == result.directory.modified) {
+                result.directory.files = cached_directory->files;
+                result.directory.subdirectories = cached_directory->subdirectories;
+                result.rescanned = false;
+            }
+            else {
+                std::filesystem::directory_iterator iterator(path, std::filesystem::directory_options::skip_permission_denied, error);
+                for(std::filesystem::directory_iterator end; !error && iterator != end; iterator.increment(error)) {
+                    auto &entry = *iterator;
+                    std::error_code entry_error;
+
+                    if(entry.is_regular_file(entry_error)) {
+                        auto size = entry.file_size(entry_error);
+                        auto file_modified = entry.last_write_time(entry_error);
+                        result.directory.files.emplace_back(File {
+                            QString::fromStdU16String(entry.path().filename().u16string()),
+                            static_cast<qint64>(size),
+                            modified_time(file_modified)
+                        });
+                    }
+                    else if(entry.is_directory(entry_error)) {
+                        result.directory.subdirectories.emplace_back(QString::fromStdU16String(entry.path().filename().u16string()));
+                    }
+                }
+
+                if(error) {
+                    std::fprintf(stderr, "Failed to query %s: %s\n", path.string().c_str(), error.message().c_str());
+                }
+
+                result.rescanned = true;
+            }
+
+            for(auto &subdirectory : result.directory.subdirectories) {
+                subdirectories.emplace_back(path / subdirectory.toStdU16String());
+            }
+
+            visited[thread].emplace_back(std::move(result));
+        }, thread_count);
+
+        // Save it again if anything changed (including directories that are gone now)
+        DirectoryMap current;
+        bool changed = false;
+        std::size_t file_count = 0;
+        for(auto &i : visited) {
+            for(auto &directory : i) {
+                changed = changed || directory.rescanned;
+                file_count += directory.directory.files.size();
+                current.insert(directory.path, std::move(directory.directory));
+            }
+        }
+        changed = changed || current.size() != cached.size();
+
+        this->tags.clear();
+        this->tags.reserve(file_count);
+        this->directories.clear();
+        this->directories.reserve(current.size());
+        auto separator = QChar(std::filesystem::path::preferred_separator);
+        for(auto i = current.cbegin(); i != current.cend(); i++) {
+            this->directories.emplace_back(i.key());
+            for(auto &file : i->files) {
+                this->tags.emplace_back(Tag { i.key().isEmpty() ? file.name : i.key() + separator + file.name, file.size, file.modified });
+            }
+        }
+
+        if(changed) {
+            this->save(current);
+        }
+    }
+}
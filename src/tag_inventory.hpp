@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SIX_SHOOTER_TAG_INVENTORY_HPP
+#define SIX_SHOOTER_TAG_INVENTORY_HPP
+
+#include <QHash>
+#include <QString>
+#include <filesystem>
+#include <vector>
+
+namespace SixShooter {
+    // Every file in a tags directory, cached on disk between runs.
+    //
+    // Adding, removing or renaming something changes the mtime of the directory it's in, so only those directories get
+    // read again; everything else is taken from the cache. Sizes and mtimes of tags that were changed in place can be
+    // out of date until something else changes in their directory.
+    class TagInventory {
+    public:
+        struct Tag {
+            // Relative to the tags directory
+            QString path;
+            qint64 size;
+            qint64 modified;
+
+            // The class is the extension
+            QStringView tag_class() const noexcept;
+        };
+
+        TagInventory(const std::filesystem::path &tags_directory);
+
+        // Load the cache, read whatever changed and save the cache again. Blocks, so don't call it from the GUI thread.
+        void update(unsigned int thread_count = 0);
+
+        const std::vector<Tag> &get_tags() const noexcept {
+            return this->tags;
+        }
+
+        // Every directory, relative to the tags directory (empty for the tags directory itself)
+        const std::vector<QString> &get_directories() const noexcept {
+            return this->directories;
+        }
+
+        const std::filesystem::path &get_tags_directory() const noexcept {
+            return this->tags_directory;
+        }
+
+    private:
+        struct File {
+            QString name;
+            qint64 size;
+            qint64 modified;
+        };
+
+        struct Directory {
+            qint64 modified;
+            std::vector<File> files;
+            std::vector<QString> subdirectories;
+        };
+
+        // Keyed by path relative to the tags directory (empty for the tags directory itself)
+        using DirectoryMap = QHash<QString, Directory>;
+
+        QString get_cache_path() const;
+        bool load(DirectoryMap &directories) const;
+        void save(const DirectoryMap &directories) const;
+
+        std::filesystem::path tags_directory;
+        std::vector<Tag> tags;
+        std::vector<QString> directories;
+    };
+}
+
+#endif
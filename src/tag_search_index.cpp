@@ -0,0 +1,259 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <algorithm>
+#include <deque>
+
+#include "tag_search_index.hpp"
+
+namespace SixShooter {
+    static quint64 trigram_at(QStringView text, qsizetype i) noexcept {
+        return (static_cast<quint64>(text[i].unicode()) << 32) | (static_cast<quint64>(text[i + 1].unicode()) << 16) | text[i + 2].unicode();
+    }
+
+    // Match the whole of text against a pattern with * and ? wildcards
+    static bool glob_match(QStringView pattern, QStringView text) noexcept {
+        qsizetype p = 0, t = 0;
+        qsizetype star = -1, star_text = 0;
+
+        while(t < text.size()) {
+            if(p < pattern.size() && (pattern[p] == u'?' || pattern[p] == text[t])) {
+                p++;
+                t++;
+            }
+            else if(p < pattern.size() && pattern[p] == u'*') {
+                star = p++;
+                star_text = t;
+            }
+            else if(star != -1) {
+                // Let the last star eat one more character and try again
+                p = star + 1;
+                t = ++star_text;
+            }
+            else {
+                return false;
+            }
+        }
+
+        while(p < pattern.size() && pattern[p] == u'*') {
+            p++;
+        }
+
+        return p == pattern.size();
+    }
+
+    static void collect_tags(const TagTree::Node &node, std::vector<const TagTree::Node *> &tags) {
+        for(auto &child : node.children) {
+            if(child->kind == TagTree::Node::Kind::Tag) {
+                tags.emplace_back(child.get());
+            }
+            else {
+                collect_tags(*child, tags);
+            }
+        }
+    }
+
+    void TagSearchIndex::clear() {
+        this->tags.clear();
+        this->entries.clear();
+        this->paths.clear();
+        this->tag_class_ids.clear();
+        this->tags_by_class.clear();
+        this->trigrams.clear();
+    }
+
+    void TagSearchIndex::build(const TagTree &tree) {
+        this->clear();
+
+        collect_tags(tree.get_root(), this->tags);
+        this->entries.reserve(this->tags.size());
+
+        for(std::uint32_t tag = 0; tag < this->tags.size(); tag++) {
+            auto lowercase = this->tags[tag]->path.toLower();
+
+            Entry entry;
+            entry.offset = static_cast<std::uint32_t>(this->paths.size());
+            entry.length = static_cast<std::uint32_t>(lowercase.size());
+            entry.tag_class = NO_CLASS;
+            this->paths.append(reinterpret_cast<const char16_t *>(lowercase.utf16()), lowercase.size());
+
+            // The class is the extension
+            auto dot = lowercase.lastIndexOf(u'.');
+            if(dot > lowercase.lastIndexOf(u'\\')) {
+                auto tag_class = lowercase.mid(dot + 1);
+                auto id = this->tag_class_ids.constFind(tag_class);
+                if(id == this->tag_class_ids.constEnd()) {
+                    id = this->tag_class_ids.insert(tag_class, static_cast<std::uint32_t>(this->tags_by_class.size()));
+                    this->tags_by_class.emplace_back();
+                }
+                entry.tag_class = *id;
+                this->tags_by_class[*id].emplace_back(tag);
+            }
+
+            this->entries.emplace_back(entry);
+
+            // Tags are added in order, so checking the end is enough to keep each posting list free of duplicates
+            auto path = this->path_of(tag);
+            for(qsizetype i = 0; i + 2 < path.size(); i++) {
+                auto &postings = this->trigrams[trigram_at(path, i)];
+                if(postings.empty() || postings.back() != tag) {
+                    postings.emplace_back(tag);
+                }
+            }
+        }
+    }
+
+    const std::vector<std::uint32_t> *TagSearchIndex::candidates_for(QStringView literal, bool &impossible) const {
+        const std::vector<std::uint32_t> *rarest = nullptr;
+
+        for(qsizetype i = 0; i + 2 < literal.size(); i++) {
+            auto postings = this->trigrams.constFind(trigram_at(literal, i));
+            if(postings == this->trigrams.constEnd()) {
+                impossible = true;
+                return nullptr;
+            }
+            if(rarest == nullptr || postings->size() < rarest->size()) {
+                rarest = &*postings;
+            }
+        }
+
+        return rarest;
+    }
+
+    std::vector<std::uint32_t> TagSearchIndex::search(QStringView query) const {
+        std::vector<std::uint32_t> results;
+
+        struct Term {
+            enum Kind {
+                Substring,
+                Glob,
+                TagClass
+            };
+
+            Kind kind;
+            QStringView text;
+
+            // Which classes match, by ID (class terms only)
+            std::vector<bool> tag_classes;
+        };
+
+        // Only the query gets copied; paths are compared in place
+        auto lowercase = query.toString().toLower().replace(u'/', u'\\');
+
+        std::vector<Term> terms;
+        const std::vector<std::uint32_t> *candidates = nullptr;
+
+        // Candidates for class terms that match more than one class; a deque so the pointers above stay good
+        std::deque<std::vector<std::uint32_t>> merged_candidates;
+
+        for(auto text : QStringView(lowercase).split(u' ', Qt::SkipEmptyParts)) {
+            Term term { Term::Kind::Substring, text, {} };
+            const std::vector<std::uint32_t> *term_candidates = nullptr;
+            bool impossible = false;
+            bool wildcard = text.contains(u'*') || text.contains(u'?');
+
+            if(!wildcard && text.size() > 1 && text.startsWith(u'.') && !text.contains(u'\\')) {
+                // Classes are matched by what they start with so results show up while still typing (".shader_t")
+                auto prefix = text.mid(1);
+                term.kind = Term::Kind::TagClass;
+                term.tag_classes.resize(this->tags_by_class.size());
+
+                std::vector<std::uint32_t> ids;
+                for(auto i = this->tag_class_ids.cbegin(); i != this->tag_class_ids.cend(); i++) {
+                    if(i.key().startsWith(prefix)) {
+                        term.tag_classes[*i] = true;
+                        ids.emplace_back(*i);
+                    }
+                }
+
+                if(ids.empty()) {
+                    return results;
+                }
+                else if(ids.size() == 1) {
+                    term_candidates = &this->tags_by_class[ids[0]];
+                }
+                else {
+                    // Tag indices are in tree order, so sorting the union keeps it that way
+                    auto &merged = merged_candidates.emplace_back();
+                    for(auto id : ids) {
+                        merged.insert(merged.end(), this->tags_by_class[id].begin(), this->tags_by_class[id].end());
+                    }
+                    std::sort(merged.begin(), merged.end());
+                    term_candidates = &merged;
+                }
+            }
+            else if(wildcard) {
+                // Narrow it down with the longest run without wildcards
+                QStringView longest;
+                for(auto part : text.split(u'*')) {
+                    for(auto literal : part.split(u'?')) {
+                        if(literal.size() > longest.size()) {
+                            longest = literal;
+                        }
+                    }
+                }
+                term.kind = Term::Kind::Glob;
+                term_candidates = this->candidates_for(longest, impossible);
+            }
+            else {
+                term_candidates = this->candidates_for(text, impossible);
+            }
+
+            if(impossible) {
+                return results;
+            }
+
+            if(term_candidates != nullptr && (candidates == nullptr || term_candidates->size() < candidates->size())) {
+                candidates = term_candidates;
+            }
+
+            terms.emplace_back(term);
+        }
+
+        if(terms.empty()) {
+            return results;
+        }
+
+        auto matches = [this, &terms](std::uint32_t tag) -> bool {
+            auto path = this->path_of(tag);
+            for(auto &term : terms) {
+                switch(term.kind) {
+                    case Term::Kind::Substring:
+                        if(!path.contains(term.text)) {
+                            return false;
+                        }
+                        break;
+                    case Term::Kind::Glob:
+                        if(!glob_match(term.text, path)) {
+                            return false;
+                        }
+                        break;
+                    case Term::Kind::TagClass:
+                        if(this->entries[tag].tag_class == NO_CLASS || !term.tag_classes[this->entries[tag].tag_class]) {
+                            return false;
+                        }
+                        break;
+                }
+            }
+            return true;
+        };
+
+        // Posting lists are in tree order, so the results are too
+        if(candidates != nullptr) {
+            for(auto tag : *candidates) {
+                if(matches(tag)) {
+                    results.emplace_back(tag);
+                }
+            }
+        }
+        else {
+            auto tag_count = static_cast<std::uint32_t>(this->tags.size());
+            for(std::uint32_t tag = 0; tag < tag_count; tag++) {
+                if(matches(tag)) {
+                    results.emplace_back(tag);
+                }
+            }
+        }
+
+        return results;
+    }
+}
@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SIX_SHOOTER_TAG_SEARCH_INDEX_HPP
+#define SIX_SHOOTER_TAG_SEARCH_INDEX_HPP
+
+#include <QHash>
+#include <QStringView>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "tag_tree.hpp"
+
+namespace SixShooter {
+    // Trigram index over the tag paths of a TagTree for searching as you type.
+    //
+    // A query is any number of space-separated terms, all of which have to match (case-insensitive):
+    // - ".bitmap" matches tags of any class starting with that (".bitm" does too)
+    // - "*" and "?" make a glob that has to match the whole path ("weapons\*\*.weapon")
+    // - anything else matches anywhere in the path
+    class TagSearchIndex {
+    public:
+        void build(const TagTree &tree);
+        void clear();
+
+        // Indices into get_tags() of every tag that matches, in tree order
+        std::vector<std::uint32_t> search(QStringView query) const;
+
+        // Every tag in tree order
+        const std::vector<const TagTree::Node *> &get_tags() const noexcept {
+            return this->tags;
+        }
+
+    private:
+        struct Entry {
+            std::uint32_t offset;
+            std::uint32_t length;
+            std::uint32_t tag_class;
+        };
+
+        static constexpr std::uint32_t NO_CLASS = UINT32_MAX;
+
+        QStringView path_of(std::uint32_t tag) const noexcept {
+            auto &entry = this->entries[tag];
+            return QStringView(this->paths.data() + entry.offset, entry.length);
+        }
+
+        // Posting list for the rarest trigram in the given text, or nullptr if it's too short to have any
+        const std::vector<std::uint32_t> *candidates_for(QStringView literal, bool &impossible) const;
+
+        std::vector<const TagTree::Node *> tags;
+        std::vector<Entry> entries;
+
+        // Lowercase paths, back to back
+        std::u16string paths;
+
+        QHash<QString, std::uint32_t> tag_class_ids;
+        std::vector<std::vector<std::uint32_t>> tags_by_class;
+        QHash<quint64, std::vector<std::uint32_t>> trigrams;
+    };
+}
+
+#endif
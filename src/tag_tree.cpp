@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <algorithm>
+
+#include "tag_tree.hpp"
+
+namespace SixShooter {
+    TagTree::TagTree() : root(std::make_unique<Node>()) {
+        this->root->kind = Node::Kind::Directory;
+    }
+
+    static void finish_level(TagTree::Node &node) {
+        // Each level is already sorted by name, so all that's left is moving the directories in front of the tags
+        std::stable_partition(node.children.begin(), node.children.end(), [](const std::unique_ptr<TagTree::Node> &child) {
+            return child->kind == TagTree::Node::Kind::Directory;
+        });
+
+        int row = 0;
+        for(auto &child : node.children) {
+            child->parent = &node;
+            child->row = row++;
+            if(child->kind == TagTree::Node::Kind::Directory) {
+                finish_level(*child);
+            }
+        }
+    }
+
+    void TagTree::build(const QStringList &tags) {
+        struct Entry {
+            QString path;
+            QStringList components;
+        };
+
+        std::vector<Entry> entries;
+        entries.reserve(tags.size());
+
+        for(auto &tag : tags) {
+            // Unknown
+            if(tag.trimmed().endsWith(".none") || tag.isEmpty()) {
+                continue;
+            }
+
+            auto path = QString(tag).replace(u'/', u'\\');
+            auto components = path.split(u'\\');
+            entries.emplace_back(Entry { std::move(path), std::move(components) });
+        }
+
+        // Sorting by path component puts everything in a directory next to each other, so each new path only ever has
+        // to look at the last directory added at each level
+        std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+            return std::lexicographical_compare(a.components.begin(), a.components.end(), b.components.begin(), b.components.end());
+        });
+
+        this->root = std::make_unique<Node>();
+        this->root->kind = Node::Kind::Directory;
+        this->tag_count = entries.size();
+
+        for(auto &entry : entries) {
+            auto *directory = this->root.get();
+            auto component_count = entry.components.size();
+
+            for(qsizetype i = 0; i + 1 < component_count; i++) {
+                auto &name = entry.components[i];
+                auto &children = directory->children;
+                if(children.empty() || children.back()->kind != Node::Kind::Directory || children.back()->name != name) {
+                    auto new_directory = std::make_unique<Node>();
+                    new_directory->name = name;
+                    new_directory->kind = Node::Kind::Directory;
+                    children.emplace_back(std::move(new_directory));
+                }
+                directory = children.back().get();
+            }
+
+            auto tag = std::make_unique<Node>();
+            tag->name = entry.components.back();
+            tag->kind = Node::Kind::Tag;
+            tag->path = std::move(entry.path);
+            directory->children.emplace_back(std::move(tag));
+        }
+
+        finish_level(*this->root);
+    }
+}
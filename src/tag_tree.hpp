@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SIX_SHOOTER_TAG_TREE_HPP
+#define SIX_SHOOTER_TAG_TREE_HPP
+
+#include <QString>
+#include <QStringList>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace SixShooter {
+    // Tag paths split into a directory tree. Each level is ordered directories first, then tags, both by name.
+    class TagTree {
+    public:
+        struct Node {
+            enum Kind : std::uint8_t {
+                Directory,
+                Tag
+            };
+
+            QString name;
+            Kind kind;
+
+            // Full tag path with backslashes (tags only)
+            QString path;
+
+            Node *parent = nullptr;
+            std::vector<std::unique_ptr<Node>> children;
+
+            // Position within the parent
+            int row = 0;
+        };
+
+        TagTree();
+
+        // Replace the contents with the given tag paths; ".none" tags and blank lines are skipped
+        void build(const QStringList &tags);
+
+        const Node &get_root() const noexcept {
+            return *this->root;
+        }
+        std::size_t get_tag_count() const noexcept {
+            return this->tag_count;
+        }
+
+    private:
+        std::unique_ptr<Node> root;
+        std::size_t tag_count = 0;
+    };
+}
+
+#endif
@@ -1,6 +1,7 @@
 // SPDX-License-Identifier: GPL-3.0-only
 
 #include <QVBoxLayout>
+#include <QLineEdit>
 
 #include "tag_tree_dialog.hpp"
 #include "tag_tree_widget.hpp"
@@ -9,7 +10,13 @@ namespace SixShooter {
     TagTreeDialog::TagTreeDialog(QWidget *parent) : QDialog(parent) {
         this->tree = new TagTreeWidget(this);
         auto *layout = new QVBoxLayout(this);
-        connect(this->tree, &TagTreeWidget::itemDoubleClicked, this, &TagTreeDialog::double_clicked);
+
+        auto *filter = new QLineEdit(this);
+        filter->setPlaceholderText("Filter (e.g. warthog, .scenario, levels\\*\\*.scenario)");
+        filter->setClearButtonEnabled(true);
+        connect(filter, &QLineEdit::textChanged, this->tree, &TagTreeWidget::set_filter);
+        layout->addWidget(filter);
+        connect(this->tree, &TagTreeWidget::doubleClicked, this, &TagTreeDialog::double_clicked);
         layout->addWidget(this->tree);
         this->setLayout(layout);
         this->setMinimumHeight(600);
@@ -20,14 +27,18 @@ namespace SixShooter {
         this->tree->set_data(tags);
     }
     
-    void TagTreeDialog::double_clicked(QTreeWidgetItem *item, int column) {
-        auto data = item->data(column, Qt::UserRole);
+    void TagTreeDialog::double_clicked(const QModelIndex &index) {
+        auto data = index.data(Qt::UserRole);
         if(!data.isNull()) {
             this->result = data.toString();
             QDialog::accept();
         }
     }
     
+    void TagTreeDialog::set_pending(const QString &message) {
+        this->tree->set_pending(message);
+    }
+    
     QString TagTreeDialog::get_result() {
         return this->result;
     }
@@ -5,7 +5,7 @@
 
 #include <QDialog>
 
-class QTreeWidgetItem;
+class QModelIndex;
 
 namespace SixShooter {
     class TagTreeWidget;
@@ -15,12 +15,13 @@ namespace SixShooter {
     public:
         TagTreeDialog(QWidget *parent = nullptr);
         void set_data(QStringList tags);
+        void set_pending(const QString &message);
         QString get_result();
         
     private:
         TagTreeWidget *tree;
         QString result;
-        void double_clicked(QTreeWidgetItem *item, int column);
+        void double_clicked(const QModelIndex &index);
     };
 }
 
@@ -0,0 +1,247 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#include <QFileIconProvider>
+#include <algorithm>
+
+#include "tag_tree_model.hpp"
+
+namespace SixShooter {
+    TagTreeModel::TagTreeModel(QObject *parent) : QAbstractItemModel(parent), snapshot(std::make_shared<Snapshot>()) {
+        this->dir_icon = QFileIconProvider().icon(QFileIconProvider::Folder);
+        this->file_icon = QFileIconProvider().icon(QFileIconProvider::File);
+    }
+
+    std::shared_ptr<const TagTreeModel::Snapshot> TagTreeModel::make_snapshot(const QStringList &tags) {
+        auto snapshot = std::make_shared<Snapshot>();
+        snapshot->tree.build(tags);
+        snapshot->search_index.build(snapshot->tree);
+        return snapshot;
+    }
+
+    void TagTreeModel::set_snapshot(std::shared_ptr<const Snapshot> snapshot) {
+        this->beginResetModel();
+        this->snapshot = std::move(snapshot);
+        this->fetched.clear();
+        this->filtered = false;
+        this->visible_children.clear();
+        this->visible_rows.clear();
+        this->endResetModel();
+    }
+
+    std::size_t TagTreeModel::set_filter(QStringView query) {
+        this->beginResetModel();
+        this->fetched.clear();
+        this->visible_children.clear();
+        this->visible_rows.clear();
+        this->filtered = !query.trimmed().isEmpty();
+
+        std::size_t match_count = 0;
+
+        if(this->filtered) {
+            auto &tags = this->snapshot->search_index.get_tags();
+            auto *root = &this->snapshot->tree.get_root();
+
+            // Add a node (and any directories above it not yet shown) to its parent's visible children. Matches come
+            // in tree order, so every level ends up ordered the same as the full tree.
+            auto show = [this, root](const TagTree::Node *node, auto &show_ref) -> void {
+                auto *parent = node->parent;
+                if(parent != root && !this->visible_rows.contains(parent)) {
+                    show_ref(parent, show_ref);
+                }
+                auto &siblings = this->visible_children[parent];
+                this->visible_rows.insert(node, static_cast<int>(siblings.size()));
+                siblings.emplace_back(node);
+            };
+
+            auto matches = this->snapshot->search_index.search(query);
+            for(auto tag : matches) {
+                show(tags[tag], show);
+            }
+            match_count = matches.size();
+
+            // Small results get shown in full right away so they can be expanded all at once
+            if(match_count <= FETCH_BATCH_SIZE) {
+                for(auto i = this->visible_children.cbegin(); i != this->visible_children.cend(); i++) {
+                    this->fetched.insert(i.key(), static_cast<int>(i->size()));
+                }
+            }
+        }
+
+        this->endResetModel();
+        return match_count;
+    }
+
+    const TagTree::Node *TagTreeModel::node_for(const QModelIndex &index) const noexcept {
+        if(!index.isValid()) {
+            return &this->snapshot->tree.get_root();
+        }
+        return static_cast<const TagTree::Node *>(index.internalPointer());
+    }
+
+    std::vector<const TagTree::Node *> TagTreeModel::get_shown_tags(const TagTree::Node *directory) const {
+        std::vector<const TagTree::Node *> tags;
+        auto add = [this, &tags](const TagTree::Node *node, auto &add_ref) -> void {
+            auto count = this->child_count(node);
+            for(int row = 0; row < count; row++) {
+                auto *child = this->child(node, row);
+                if(child->kind == TagTree::Node::Kind::Tag) {
+                    tags.emplace_back(child);
+                }
+                else {
+                    add_ref(child, add_ref);
+                }
+            }
+        };
+        add(directory, add);
+        return tags;
+    }
+
+    TagTreeModel::NodePath TagTreeModel::path_of(const TagTree::Node *node) {
+        NodePath path { QStringList(), node->kind };
+        for(; node->parent != nullptr; node = node->parent) {
+            path.first.prepend(node->name);
+        }
+        return path;
+    }
+
+    std::vector<QModelIndex> TagTreeModel::find(const std::vector<NodePath> &paths) {
+        // Rows of each directory's children by name, built as they're needed; tags and directories are kept apart
+        QHash<const TagTree::Node *, QHash<QString, int>> rows;
+        auto key = [](const QString &name, TagTree::Node::Kind kind) {
+            return kind == TagTree::Node::Kind::Tag ? name + QChar() : name;
+        };
+
+        std::vector<QModelIndex> found;
+        found.reserve(paths.size());
+
+        for(auto &[names, kind] : paths) {
+            auto *node = &this->snapshot->tree.get_root();
+            QModelIndex index;
+
+            for(qsizetype i = 0; i < names.size() && node != nullptr; i++) {
+                auto existing = rows.find(node);
+                if(existing == rows.end()) {
+                    existing = rows.insert(node, {});
+                    auto count = this->child_count(node);
+                    for(int row = 0; row < count; row++) {
+                        auto *child = this->child(node, row);
+                        existing->insert(key(child->name, child->kind), row);
+                    }
+                }
+
+                auto row = existing->value(key(names[i], i + 1 == names.size() ? kind : TagTree::Node::Kind::Directory), -1);
+                if(row < 0) {
+                    node = nullptr;
+                    break;
+                }
+
+                while(this->fetched_rows(node) <= row) {
+                    this->fetchMore(index);
+                }
+                node = this->child(node, row);
+                index = this->createIndex(row, 0, const_cast<TagTree::Node *>(node));
+            }
+
+            found.emplace_back(node != nullptr ? index : QModelIndex());
+        }
+
+        return found;
+    }
+
+    int TagTreeModel::fetched_rows(const TagTree::Node *node) const noexcept {
+        return this->fetched.value(node, 0);
+    }
+
+    int TagTreeModel::child_count(const TagTree::Node *node) const noexcept {
+        if(!this->filtered) {
+            return static_cast<int>(node->children.size());
+        }
+        auto children = this->visible_children.constFind(node);
+        return children == this->visible_children.constEnd() ? 0 : static_cast<int>(children->size());
+    }
+
+    const TagTree::Node *TagTreeModel::child(const TagTree::Node *node, int row) const noexcept {
+        if(!this->filtered) {
+            return node->children[row].get();
+        }
+        return (*this->visible_children.constFind(node))[row];
+    }
+
+    int TagTreeModel::row_of(const TagTree::Node *node) const noexcept {
+        return this->filtered ? this->visible_rows.value(node) : node->row;
+    }
+
+    QModelIndex TagTreeModel::index(int row, int column, const QModelIndex &parent) const {
+        auto *node = this->node_for(parent);
+        if(column != 0 || row < 0 || row >= this->fetched_rows(node)) {
+            return QModelIndex();
+        }
+        return this->createIndex(row, column, const_cast<TagTree::Node *>(this->child(node, row)));
+    }
+
+    QModelIndex TagTreeModel::parent(const QModelIndex &index) const {
+        if(!index.isValid()) {
+            return QModelIndex();
+        }
+
+        auto *parent = this->node_for(index)->parent;
+        if(parent == nullptr || parent == &this->snapshot->tree.get_root()) {
+            return QModelIndex();
+        }
+        return this->createIndex(this->row_of(parent), 0, parent);
+    }
+
+    int TagTreeModel::rowCount(const QModelIndex &parent) const {
+        if(parent.column() > 0) {
+            return 0;
+        }
+        return this->fetched_rows(this->node_for(parent));
+    }
+
+    int TagTreeModel::columnCount(const QModelIndex &) const {
+        return 1;
+    }
+
+    bool TagTreeModel::hasChildren(const QModelIndex &parent) const {
+        // Report children before they're fetched so unexpanded directories can still be expanded
+        return this->child_count(this->node_for(parent)) > 0;
+    }
+
+    QVariant TagTreeModel::data(const QModelIndex &index, int role) const {
+        if(!index.isValid()) {
+            return QVariant();
+        }
+
+        auto *node = this->node_for(index);
+        bool directory = node->kind == TagTree::Node::Kind::Directory;
+
+        switch(role) {
+            case Qt::DisplayRole:
+                return node->name;
+            case Qt::DecorationRole:
+                return directory ? this->dir_icon : this->file_icon;
+            case Qt::UserRole:
+                return directory ? QVariant() : QVariant(node->path);
+            default:
+                return QVariant();
+        }
+    }
+
+    bool TagTreeModel::canFetchMore(const QModelIndex &parent) const {
+        auto *node = this->node_for(parent);
+        return this->fetched_rows(node) < this->child_count(node);
+    }
+
+    void TagTreeModel::fetchMore(const QModelIndex &parent) {
+        auto *node = this->node_for(parent);
+        int first = this->fetched_rows(node);
+        int count = std::min(this->child_count(node) - first, FETCH_BATCH_SIZE);
+        if(count <= 0) {
+            return;
+        }
+
+        this->beginInsertRows(parent, first, first + count - 1);
+        this->fetched[node] = first + count;
+        this->endInsertRows();
+    }
+}
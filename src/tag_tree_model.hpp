@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: GPL-3.0-only
+
+#ifndef SIX_SHOOTER_TAG_TREE_MODEL_HPP
+#define SIX_SHOOTER_TAG_TREE_MODEL_HPP
+
+#include <QAbstractItemModel>
+#include <QHash>
+#include <QIcon>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "tag_tree.hpp"
+#include "tag_search_index.hpp"
+
+namespace SixShooter {
+    // Tag tree for views. Rows are only handed to the view as directories get expanded, so a huge map shows its top level
+    // right away. Tags have their full path in Qt::UserRole; directories have nothing there.
+    //
+    // While filtered, only matching tags and the directories leading to them are shown.
+    class TagTreeModel : public QAbstractItemModel {
+        Q_OBJECT
+    public:
+        // Everything built from a tag list. Never changed once built, so it can be built on any thread.
+        struct Snapshot {
+            TagTree tree;
+            TagSearchIndex search_index;
+        };
+
+        TagTreeModel(QObject *parent = nullptr);
+
+        // Safe to call from any thread
+        static std::shared_ptr<const Snapshot> make_snapshot(const QStringList &tags);
+
+        // Swap in a new tree; this only resets the model, so it takes the same time no matter how many tags there are
+        void set_snapshot(std::shared_ptr<const Snapshot> snapshot);
+        void set_tags(const QStringList &tags) {
+            this->set_snapshot(make_snapshot(tags));
+        }
+
+        // Show only tags matching the query (see TagSearchIndex); an empty query shows everything again. Returns the
+        // number of matching tags.
+        std::size_t set_filter(QStringView query);
+        bool is_filtered() const noexcept {
+            return this->filtered;
+        }
+        const TagTree &get_tree() const noexcept {
+            return this->snapshot->tree;
+        }
+
+        // Tags shown anywhere under a directory, which is all of them unless filtered
+        std::vector<const TagTree::Node *> get_shown_tags(const TagTree::Node *directory) const;
+
+        // Node for an index, or the root for an invalid index
+        const TagTree::Node *node_for(const QModelIndex &index) const noexcept;
+
+        // Names leading from the root to a node, and the indices of nodes found by them (fetching rows as needed, and
+        // invalid if not there), so the same places can be found again after swapping in another snapshot
+        using NodePath = std::pair<QStringList, TagTree::Node::Kind>;
+        static NodePath path_of(const TagTree::Node *node);
+        std::vector<QModelIndex> find(const std::vector<NodePath> &paths);
+
+        QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+        QModelIndex parent(const QModelIndex &index) const override;
+        int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+        int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+        bool hasChildren(const QModelIndex &parent = QModelIndex()) const override;
+        QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+        bool canFetchMore(const QModelIndex &parent) const override;
+        void fetchMore(const QModelIndex &parent) override;
+
+    private:
+        // How many rows to hand over per fetch
+        static constexpr int FETCH_BATCH_SIZE = 1024;
+
+        int fetched_rows(const TagTree::Node *node) const noexcept;
+        int child_count(const TagTree::Node *node) const noexcept;
+        const TagTree::Node *child(const TagTree::Node *node, int row) const noexcept;
+        int row_of(const TagTree::Node *node) const noexcept;
+
+        std::shared_ptr<const Snapshot> snapshot;
+        QHash<const TagTree::Node *, int> fetched;
+
+        // Visible children of each directory and where each visible node is in its parent (filtered only)
+        bool filtered = false;
+        QHash<const TagTree::Node *, std::vector<const TagTree::Node *>> visible_children;
+        QHash<const TagTree::Node *, int> visible_rows;
+        QIcon dir_icon;
+        QIcon file_icon;
+    };
+}
+
+#endif
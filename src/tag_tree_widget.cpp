@@ -1,157 +1,196 @@
 // SPDX-License-Identifier: GPL-3.0-only
 
-#include <QHBoxLayout>
-#include <QVBoxLayout>
-#include <QGridLayout>
-#include <QGroupBox>
-#include <QLabel>
-#include <QComboBox>
-#include <QCheckBox>
-#include <QLineEdit>
-#include <QTreeWidget>
-#include <QPushButton>
 #include <QHeaderView>
-#include <QFileIconProvider>
+#include <QPainter>
+#include <QScrollBar>
+#include <QSet>
+#include <QThread>
 
 #include "tag_tree_widget.hpp"
 
 namespace SixShooter {
-    TagTreeWidget::TagTreeWidget(QWidget *parent) : QTreeWidget(parent) {
+    TagTreeWidget::TagTreeWidget(QWidget *parent) : QTreeView(parent) {
+        this->tag_model = new TagTreeModel(this);
+        this->setModel(this->tag_model);
+
         this->header()->setStretchLastSection(true);
-        this->setColumnCount(1);
         this->setHeaderHidden(true);
         this->setAlternatingRowColors(true);
         this->setAnimated(false);
+        this->setUniformRowHeights(true);
+        this->setEditTriggers(QAbstractItemView::EditTrigger::NoEditTriggers);
     }
     
     void TagTreeWidget::set_data(QStringList tags) {
-        QIcon dir_icon = QFileIconProvider().icon(QFileIconProvider::Folder);
-        QIcon file_icon = QFileIconProvider().icon(QFileIconProvider::File);
-        
-        for(auto &tag : tags) {
-            // Unknown
-            if(tag.trimmed().endsWith(".none")) {
+        this->set_pending(QString("Loading %1 tag%2...").arg(tags.size()).arg(tags.size() == 1 ? "" : "s"));
+        this->load(std::move(tags));
+    }
+
+    void TagTreeWidget::update_data(QStringList tags) {
+        this->load(std::move(tags));
+    }
+
+    void TagTreeWidget::load(QStringList tags) {
+        if(this->building) {
+            this->waiting_tags = std::move(tags);
+            return;
+        }
+        this->building = true;
+        auto generation = this->load_generation;
+
+        // Splitting, sorting and indexing all happen on the worker; swapping the result in is just a model reset
+        auto result = std::make_shared<std::shared_ptr<const TagTreeModel::Snapshot>>();
+        auto *thread = QThread::create([tags = std::move(tags), result]() {
+            *result = TagTreeModel::make_snapshot(tags);
+        });
+
+        connect(thread, &QThread::finished, this, [this, result, generation]() {
+            this->building = false;
+
+            // Lists given since set_pending are the same list as it grows, so show each as it's done, keeping whatever
+            // was expanded or selected where it was
+            if(generation == this->load_generation) {
+                auto state = this->save_view_state();
+                this->loading_message.clear();
+                this->tag_model->set_snapshot(std::move(*result));
+                if(!this->filter.isEmpty()) {
+                    this->set_filter(this->filter);
+                }
+                this->restore_view_state(state);
+                this->viewport()->update();
+            }
+
+            if(this->waiting_tags.has_value()) {
+                auto tags = std::move(*this->waiting_tags);
+                this->waiting_tags.reset();
+                this->load(std::move(tags));
+            }
+        });
+        connect(thread, &QThread::finished, thread, &QObject::deleteLater);
+        thread->start();
+    }
+
+    void TagTreeWidget::set_pending(const QString &message) {
+        this->load_generation++;
+        this->waiting_tags.reset();
+        this->loading_message = message;
+        this->tag_model->set_snapshot(std::make_shared<TagTreeModel::Snapshot>());
+        this->viewport()->update();
+    }
+
+    TagTreeWidget::ViewState TagTreeWidget::save_view_state() const {
+        ViewState state;
+
+        // Only fetched rows can be expanded, so there's no need to look any further
+        auto add_expanded = [this, &state](const QModelIndex &parent, auto &add_expanded_ref) -> void {
+            auto rows = this->tag_model->rowCount(parent);
+            for(int row = 0; row < rows; row++) {
+                auto index = this->tag_model->index(row, 0, parent);
+                if(this->isExpanded(index)) {
+                    state.expanded.emplace_back(TagTreeModel::path_of(this->tag_model->node_for(index)));
+                    add_expanded_ref(index, add_expanded_ref);
+                }
+            }
+        };
+        add_expanded(QModelIndex(), add_expanded);
+
+        for(auto &i : this->selectionModel()->selectedRows()) {
+            state.selected.emplace_back(TagTreeModel::path_of(this->tag_model->node_for(i)));
+        }
+        if(this->currentIndex().isValid()) {
+            state.current = TagTreeModel::path_of(this->tag_model->node_for(this->currentIndex()));
+        }
+        state.scroll = this->verticalScrollBar()->value();
+
+        return state;
+    }
+
+    void TagTreeWidget::restore_view_state(const ViewState &state) {
+        // Parents come before their children, so each is there to be expanded by the time it's needed
+        for(auto &i : this->tag_model->find(state.expanded)) {
+            if(i.isValid()) {
+                this->setExpanded(i, true);
+            }
+        }
+
+        if(state.current.has_value()) {
+            auto current = this->tag_model->find({ *state.current }).front();
+            if(current.isValid()) {
+                this->selectionModel()->setCurrentIndex(current, QItemSelectionModel::SelectionFlag::NoUpdate);
+            }
+        }
+
+        QItemSelection selection;
+        for(auto &i : this->tag_model->find(state.selected)) {
+            if(i.isValid()) {
+                selection.select(i, i);
+            }
+        }
+        if(!selection.isEmpty()) {
+            this->selectionModel()->select(selection, QItemSelectionModel::SelectionFlag::ClearAndSelect | QItemSelectionModel::SelectionFlag::Rows);
+        }
+
+        this->verticalScrollBar()->setValue(state.scroll);
+    }
+
+    void TagTreeWidget::set_filter(const QString &query) {
+        this->filter = query;
+        if(this->is_loading()) {
+            return;
+        }
+
+        auto match_count = this->tag_model->set_filter(query);
+        if(this->tag_model->is_filtered() && match_count <= AUTO_EXPAND_LIMIT) {
+            this->expandAll();
+        }
+    }
+
+    QStringList TagTreeWidget::get_selected_searches() const {
+        QSet<const TagTree::Node *> selected;
+        for(auto &i : this->selectionModel()->selectedRows()) {
+            selected.insert(this->tag_model->node_for(i));
+        }
+
+        QStringList searches;
+        for(auto *node : selected) {
+            bool in_selected_folder = false;
+            for(auto *parent = node->parent; parent != nullptr && !in_selected_folder; parent = parent->parent) {
+                in_selected_folder = selected.contains(parent);
+            }
+            if(in_selected_folder) {
                 continue;
             }
-        
-            QString formatted = tag.replace("/", "\\");
-            
-            auto dir_split = formatted.split("\\");
-            auto dir_split_length = dir_split.size();
-            
-            if(dir_split_length == 0) {
-                continue; // ok weird
+
+            if(node->kind == TagTree::Node::Kind::Tag) {
+                searches << node->path;
             }
-            
-            QTreeWidgetItem *directory = nullptr;
-            for(std::size_t i = 0; i < dir_split_length; i++) {
-                // Adding it now!
-                if(i + 1 == dir_split_length) {
-                    auto *item = new QTreeWidgetItem(QStringList(dir_split[i]));
-                    item->setData(0, Qt::UserRole, tag);
-                    item->setIcon(0, file_icon);
-                    
-                    if(directory == nullptr) {
-                        int child_count = this->topLevelItemCount();
-                        int insertion_point = child_count;
-                        
-                        for(int j = 0; j < child_count; j++) {
-                            auto *item = this->topLevelItem(j);
-                            if(item->text(0) > dir_split[i] && item->icon(0).name() != dir_icon.name()) {
-                                insertion_point = j;
-                                break;
-                            }
-                        }
-                        
-                        this->insertTopLevelItem(insertion_point, item);
-                    }
-                    else {
-                        int child_count = directory->childCount();
-                        int insertion_point = child_count;
-                        
-                        for(int j = 0; j < child_count; j++) {
-                            auto *item = directory->child(j);
-                            if(item->text(0) > dir_split[i] && item->icon(0).name() != dir_icon.name()) {
-                                insertion_point = j;
-                                break;
-                            }
-                        }
-                        
-                        directory->insertChild(insertion_point, item);
-                    }
+            else if(this->tag_model->is_filtered()) {
+                // Only what the filter shows of the folder, not everything in it
+                for(auto *tag : this->tag_model->get_shown_tags(node)) {
+                    searches << tag->path;
                 }
-                
-                // Find the directory with it
-                else {
-                    auto directory_we_are_looking_for = [&directory, &dir_icon, &i, &dir_split](QTreeWidgetItem *item) -> bool {
-                        if(item->text(0) == dir_split[i] && item->icon(0).name() == dir_icon.name()) {
-                            directory = item;
-                            return true;
-                        }
-                        else {
-                            return false;
-                        }
-                    };
-                    
-                    // Hold this in case we change it
-                    auto *old_directory = directory;
-                    
-                    if(directory == nullptr) {
-                        int child_count = this->topLevelItemCount();
-                        for(int i = 0; i < child_count; i++) {
-                            if(directory_we_are_looking_for(this->topLevelItem(i))) {
-                                break;
-                            }
-                        }
-                    }
-                    else {
-                        int child_count = directory->childCount();
-                        for(int i = 0; i < child_count; i++) {
-                            if(directory_we_are_looking_for(directory->child(i))) {
-                                break;
-                            }
-                        }
-                    }
-                    
-                    // Directory changed. Proceed.
-                    if(old_directory != directory) {
-                        continue;
-                    }
-                    
-                    // Not found? Make the directory then.
-                    auto *new_directory = new QTreeWidgetItem(QStringList(dir_split[i]));
-                    new_directory->setIcon(0, dir_icon);
-                    if(directory == nullptr) {
-                        int child_count = this->topLevelItemCount();
-                        int insertion_point = child_count;
-                        
-                        for(int j = 0; j < child_count; j++) {
-                            auto *item = this->topLevelItem(j);
-                            if(item->text(0) > dir_split[i] || item->icon(0).name() != dir_icon.name()) {
-                                insertion_point = j;
-                                break;
-                            }
-                        }
-                        
-                        this->insertTopLevelItem(insertion_point, new_directory);
-                    }
-                    else {
-                        int child_count = directory->childCount();
-                        int insertion_point = child_count;
-                        
-                        for(int j = 0; j < child_count; j++) {
-                            auto *item = directory->child(j);
-                            if(item->text(0) > dir_split[i] || item->icon(0).name() != dir_icon.name()) {
-                                insertion_point = j;
-                                break;
-                            }
-                        }
-                        
-                        directory->insertChild(insertion_point, new_directory);
-                    }
-                    directory = new_directory;
+            }
+            else {
+                QStringList components;
+                for(auto *i = node; i->parent != nullptr; i = i->parent) {
+                    components.prepend(i->name);
                 }
+                searches << components.join('\\') + "\\*";
             }
         }
+
+        searches.sort();
+        return searches;
+    }
+
+    void TagTreeWidget::paintEvent(QPaintEvent *event) {
+        if(!this->is_loading()) {
+            QTreeView::paintEvent(event);
+            return;
+        }
+
+        QPainter painter(this->viewport());
+        painter.setPen(this->palette().color(QPalette::ColorRole::PlaceholderText));
+        painter.drawText(this->viewport()->rect(), Qt::AlignCenter, this->loading_message);
     }
 }
@@ -3,14 +3,75 @@
 #ifndef SIX_SHOOTER_TAG_TREE_WIDGET_HPP
 #define SIX_SHOOTER_TAG_TREE_WIDGET_HPP
 
-#include <QTreeWidget>
+#include <QTreeView>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "tag_tree_model.hpp"
 
 namespace SixShooter {
-    class TagTreeWidget : public QTreeWidget {
+
+    class TagTreeWidget : public QTreeView {
         Q_OBJECT
     public:
         TagTreeWidget(QWidget *parent = nullptr);
+
+        // Build the tree on a worker thread; the tree is swapped in once it's done
         void set_data(QStringList tags);
+
+        // Same, but keep showing the current tree until the new one is built (for lists that grow as they're read)
+        void update_data(QStringList tags);
+
+        // Show a message instead of the tree until set_data is called (e.g. while the tags are still being found)
+        void set_pending(const QString &message);
+
+        // Only show tags matching the query; see TagSearchIndex for the syntax
+        void set_filter(const QString &query);
+
+        // invader-extract searches for everything selected: the path of each tag and "folder\*" for each folder (or,
+        // while filtered, the path of each tag the filter shows in it). Anything in a selected folder is left out since
+        // the folder already covers it.
+        QStringList get_selected_searches() const;
+
+        bool is_loading() const noexcept {
+            return !this->loading_message.isEmpty();
+        }
+
+        TagTreeModel *get_model() const noexcept {
+            return this->tag_model;
+        }
+
+    protected:
+        void paintEvent(QPaintEvent *event) override;
+
+    private:
+        void load(QStringList tags);
+
+        // What's expanded and selected, so it can be found again once a new tree is swapped in
+        struct ViewState {
+            std::vector<TagTreeModel::NodePath> expanded;
+            std::vector<TagTreeModel::NodePath> selected;
+            std::optional<TagTreeModel::NodePath> current;
+            int scroll = 0;
+        };
+        ViewState save_view_state() const;
+        void restore_view_state(const ViewState &state);
+
+        // Expand everything if a filter leaves no more than this many tags
+        static constexpr std::size_t AUTO_EXPAND_LIMIT = 256;
+
+        TagTreeModel *tag_model;
+        QString filter;
+
+        // Shown instead of the tree while loading
+        QString loading_message;
+
+        // Only one tree is built at a time. A list that comes in meanwhile waits for it (replacing any list that was
+        // already waiting), and trees from before the last set_pending aren't shown.
+        bool building = false;
+        std::optional<QStringList> waiting_tags;
+        std::uint64_t load_generation = 0;
     };
 }
 